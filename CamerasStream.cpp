@@ -1,103 +1,103 @@
 #include "hpp/OB2Context.hpp"
 #include "hpp/preheader.hpp"
 #include "hpp/window.hpp"
+#include "hpp/OB2Playback.hpp"
+#include "hpp/image_view.hpp"
+#include "hpp/corner_pipeline.hpp"
+#include "hpp/corner_store.hpp"
+#include "hpp/depth_colormap.hpp"
+#include "hpp/frame_pool.hpp"
+#include "hpp/acquisition.hpp"
+#include "hpp/image_saver.hpp"
+#include "hpp/incremental_calib.hpp"
+#include "hpp/stereo_calib.hpp"
+#include "hpp/undistort_map.hpp"
+#include "hpp/auto_capture.hpp"
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <string>
+#include <thread>
 
-std::vector<cv::Mat> processImages(std::vector<std::shared_ptr<ob2::image>> images) {
+std::vector<cv::Mat> processImages(std::vector<std::shared_ptr<ob2::image>> images, frame_pool &pool) {
+        static const depth_colormap colormap;
         std::vector<cv::Mat> mats;
-        void *               data;
-        uint32_t             dataSize;
         ob2_camera_type_t    cameraType;
         ob2_image_format_t   format;
-        uint32_t             width;
-        uint32_t             height;
+        cv::Size             size;
 
         for(auto im: images) {
             if(im == nullptr || im->get_size() < 1024) {
                 break;
             }
 
-            data       = im->get_buffer();
-            dataSize   = im->get_size();
+            // Convert straight from the SDK buffer, without copying it first
+            image_view view(im);
             cameraType = im->get_source_camera_type();
             format     = im->get_format();
-            width      = im->get_width_pixels();
-            height     = im->get_height_pixels();
+            size       = cv::Size(im->get_width_pixels(), im->get_height_pixels());
 
-            cv::Mat rstMat;
+            // Output buffers come from the pool, so steady-state streaming does not allocate frames
+            cv::Mat rstMat = pool.acquire(size, CV_8UC3);
             switch(cameraType) {
             case OB2_CAMERA_COLOR:
                 switch(format) {
                 case OB2_FORMAT_MJPG:
-                    rstMat = cv::Mat(1, dataSize, CV_8UC1, data).clone();
-                    rstMat = cv::imdecode(rstMat, 1);
+                    cv::imdecode(view.mat(), 1, &rstMat);
                     break;
                 case OB2_FORMAT_YUYV:
-                    rstMat = cv::Mat(height, width, CV_8UC2, data).clone();
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_YUV2BGR_YUYV);
+                    cv::cvtColor(view.mat(), rstMat, cv::COLOR_YUV2BGR_YUYV);
                     break;
                 case OB2_FORMAT_NV12:
-                    rstMat = cv::Mat(height, width, CV_8UC3, data).clone();
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_YUV2BGR_NV12);
+                    cv::cvtColor(view.mat(), rstMat, cv::COLOR_YUV2BGR_NV12);
                     break;
                 case OB2_FORMAT_RGB:
-                    rstMat = cv::Mat(height, width, CV_8UC3, data).clone();
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_RGB2BGR);
+                    cv::cvtColor(view.mat(), rstMat, cv::COLOR_RGB2BGR);
                     break;
                 default:
+                    rstMat.release();
                     break;
                 }
                 break;
             case OB2_CAMERA_DEPTH:
                 switch(format) {
-                case OB2_FORMAT_Y16: {
-                    float scale = im->get_value_scale();
-                    rstMat      = cv::Mat(height, width, CV_16UC1, data).clone();
-                    // cv::threshold(rstMat, rstMat, 6000 / scale, 0, cv::THRESH_TRUNC);
-
-                    // Scaling of depth values from 0 to 6000mm to 0 to 255
-                    rstMat = rstMat * 255 / (6000 / scale);
-
-                    // CV_16UC1 to CV_8UC1, which includes the cv::threshold operation, i.e. any value greater than 255 becomes 255
-                    rstMat.convertTo(rstMat, CV_8UC1);
-
-                    cv::applyColorMap(rstMat, rstMat, cv::COLORMAP_JET);
-                } break;
+                case OB2_FORMAT_Y16:
+                    // Depth values from 0 to 6000mm straight to JET colors in a single pass
+                    colormap.apply(view.mat(), im->get_value_scale(), rstMat);
+                    break;
                 default:
+                    rstMat.release();
                     break;
                 }
                 break;
             case OB2_CAMERA_IR:
                 switch(format) {
-                case OB2_FORMAT_Y16:
-                    rstMat = cv::Mat(height, width, CV_16UC1, data).clone();
+                case OB2_FORMAT_Y16: {
+                    cv::Mat grayMat = pool.acquire(size, CV_8UC1);
                     // cv::threshold(rstMat, rstMat, 4096, 0, cv::THRESH_TRUNC);
 
-                    // Most of the value of ir pixels are between 0 and 20102448, scaling them to 0 to 255
-                    rstMat = rstMat * 255 / 1024;
+                    // Most of the value of ir pixels are between 0 and 20102448, scaling them to 0 to 255, any value greater than 255 becomes 255
+                    view.mat().convertTo(grayMat, CV_8UC1, 255.0 / 1024);
 
-                    // CV_16UC1 to CV_8UC1, which includes the cv::threshold operation, i.e. any value greater than 255 becomes 255
-                    rstMat.convertTo(rstMat, CV_8UC1);
-
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_GRAY2BGR);
-                    break;
+                    cv::cvtColor(grayMat, rstMat, cv::COLOR_GRAY2BGR);
+                } break;
                 case OB2_FORMAT_Y8:
-                    rstMat = cv::Mat(height, width, CV_8UC1, data).clone();
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_GRAY2BGR);
+                    cv::cvtColor(view.mat(), rstMat, cv::COLOR_GRAY2BGR);
                     break;
                 case OB2_FORMAT_MJPG:
-                    rstMat = cv::Mat(1, dataSize, CV_8UC1, data).clone();
-                    rstMat = cv::imdecode(rstMat, 1);
+                    cv::imdecode(view.mat(), 1, &rstMat);
                     break;
                 default:
+                    rstMat.release();
                     break;
                 }
                 break;
             default:
+                rstMat.release();
                 break;
             }
 
@@ -108,76 +108,402 @@ std::vector<cv::Mat> processImages(std::vector<std::shared_ptr<ob2::image>> imag
         return mats;
     }
 
-int main(int argc, char **argv) TRY_EXECUTE {
-    // Create context
-    auto ctx = std::make_shared<ob2::context>();
+// 流式采集各阶段的统计：入队到被取出的等待、格式转换、去畸变、显示，以及手动保存前的清晰度评分
+struct stream_stats {
+    stage_stats queue;
+    stage_stats convert;
+    stage_stats undistort;
+    stage_stats display;
+    stage_stats focus;
+    cv::Size undistort_size;
+
+    void print(const acquisition &acq) const {
+        std::cout << "Captures: " << acq.received() << " received, " << acq.dropped() << " dropped, " << acq.skipped() << " skipped by display" << std::endl;
+        queue.print("Queue wait");
+        convert.print("Convert");
+        if(undistort.count > 0) {
+            undistort.print("Undistort");
+            std::cout << "  " << undistort_size.width << "x" << undistort_size.height << ", " << undistort.total_ms / undistort.count / (1000.0 / 30) * 100
+                      << "% of the frame budget at 30 fps" << std::endl;
+        }
+        display.print("Display");
+        if(focus.count > 0) {
+            focus.print("Focus");
+        }
+    }
+};
 
-    // Open default device
-    auto dev = ctx->open_device(OB2_DEFAULT_DEVICE);
+// 彩色图像去畸变：内参来自 calibrate 的输出，映射表在收到第一帧或分辨率变化时准备
+struct undistort_stage {
+    cv::Mat K, dist;
+    cv::Size calib_size;
+    double alpha = 0;
+    std::string cache_path;
+    undistort_map map;
+};
 
-    // Open camera (use default configuration, the default configuration will open Color, Depth, Ir camera data stream)
-    dev->start_cameras(OB2_DEFAULT_CAMERAS_CONFIG);
+// 从录制文件回放，回放线程只把 capture 放入环形队列，由当前线程转换后送入检测流水线，不打开任何窗口
+void runPlayback(const std::string &file, acquisition &acq, corner_pipeline &pipeline, frame_pool &pool, stream_stats &stats) {
+    ob2::playback pb(file);
+    pb.start(
+        [&](std::shared_ptr<ob2::capture> capture) {
+            // 回放不受实时性约束，队列满时等待而不丢帧
+            acq.submit(capture, true);
+        },
+        nullptr,
+        [&](ob2_playback_state_t state) {
+            if(state == OB2_PLAYBACK_END) {
+                acq.close();
+            }
+        });
+    stamped_capture c;
+    while(true) {
+        // 先读结束标志再取帧，保证结束前提交的帧都被取走
+        bool end = acq.closed();
+        if(!acq.next(c)) {
+            if(end) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        stats.queue.add(elapsed_ms(c.arrival));
+        std::shared_ptr<ob2::image> color_image = c.capture->get_color_image();
+        if(color_image == nullptr) {
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for(auto im: processImages({color_image}, pool)) {
+            cv::Mat gray = pool.acquire(im.size(), CV_8UC1);
+            cv::cvtColor(im, gray, cv::COLOR_BGR2GRAY);
+            stats.convert.add(elapsed_ms(start));
+            pipeline.push(gray, color_image->get_device_timestamp_usec(), true);
+        }
+    }
+    pb.stop();
+}
 
-    // Create a window for rendering and set the resolution of the window
-    //Window win("DefaultViewer", 1470, 360);
+// 出厂标定参数中深度相机即 IR 相机；SDK 的畸变系数按 k1..k6 p1 p2 排列，换成 OpenCV 的 k1 k2 p1 p2 k3..k6
+stereo_params toStereoParams(const ob2_cameras_calibration_t &calibration) {
+    auto intrinsic = [](const ob2_camera_intrinsic_t &in) -> cv::Mat {
+        return (cv::Mat_<double>(3, 3) << in.fx, 0, in.cx, 0, in.fy, in.cy, 0, 0, 1);
+    };
+    auto distortion = [](const ob2_camera_distortion_t &d) -> cv::Mat {
+        return (cv::Mat_<double>(1, 8) << d.k1, d.k2, d.p1, d.p2, d.k3, d.k4, d.k5, d.k6);
+    };
+    stereo_params p;
+    p.ir_K = intrinsic(calibration.depth_intrinsic);
+    p.ir_dist = distortion(calibration.depth_distortion);
+    p.ir_size = cv::Size(calibration.depth_intrinsic.width, calibration.depth_intrinsic.height);
+    p.color_K = intrinsic(calibration.color_Intrinsic);
+    p.color_dist = distortion(calibration.color_distortion);
+    p.color_size = cv::Size(calibration.color_Intrinsic.width, calibration.color_Intrinsic.height);
+    cv::Mat(3, 3, CV_32F, (void *)calibration.transform.rot).convertTo(p.R, CV_64F);
+    cv::Mat(3, 1, CV_32F, (void *)calibration.transform.trans).convertTo(p.T, CV_64F);
+    return p;
+}
 
+// 显示循环：每次只取队列中最新的一帧转换并显示，渲染慢时跳过积压的旧帧。
+// 按下's'的帧交给检测线程或后台写盘线程，不在显示线程中保存。
+// stereo 为 true 时同时显示 IR 图像，按下's'时把同一 capture 中的彩色和 IR 图像成对写入 ../imgs/stereo。
+// undistort 非空时显示去畸变后的彩色图像，检测和保存仍使用原图。
+// auto_opt 非空时每一帧都交给自动采集线程，标定板静止、清晰且位姿新颖的帧被自动送入检测线程或保存，'s'仍可手动保存。
+// min_focus 大于 0 时按下's'的帧清晰度低于该值则不保存
+void runDisplay(acquisition &acq, corner_pipeline *pipeline, frame_pool &pool, stream_stats &stats, bool stereo, undistort_stage *undistort,
+                const auto_capture_options *auto_opt, double min_focus) {
+    image_saver saver(stereo ? "../imgs/stereo" : "../imgs", 8);
+    cv::namedWindow("show", cv::WINDOW_NORMAL);
+    if (stereo) {
+        cv::namedWindow("ir", cv::WINDOW_NORMAL);
+    }
     std::cerr << "Into loop" << std::endl;
     char key = 0;
-    int count = 0;
-    do {
-        // Get capture
-        std::shared_ptr<ob2::capture> capture = nullptr;
-        try {
-            // Timeout is set to 100ms
-            capture = dev->get_capture(100);
+    // 自动采集线程与显示线程共用的计数，只用于显示；保存的文件名由 saver 分配
+    std::atomic<int> count(0);
+    std::unique_ptr<auto_capture> autocap;
+    if(auto_opt) {
+        autocap.reset(new auto_capture(*auto_opt, [&](const cv::Mat &bgr, const cv::Mat &gray, uint64_t timestamp_usec) {
+            if(pipeline) {
+                if(pipeline->push(gray, timestamp_usec, true)) {
+                    ++count;
+                }
+            }
+            else if(saver.push_next(bgr)) {
+                ++count;
+            }
+            else {
+                std::cout << "\nSave queue is full, frame dropped" << std::endl;
+            }
+        }));
+    }
+    auto sharp_enough = [&](const cv::Mat &im) {
+        if(min_focus <= 0) {
+            return true;
+        }
+        cv::Mat gray = pool.acquire(im.size(), CV_8UC1);
+        cv::cvtColor(im, gray, cv::COLOR_BGR2GRAY);
+        auto start = std::chrono::steady_clock::now();
+        double focus = focus_measure(gray);
+        stats.focus.add(elapsed_ms(start));
+        if(focus < min_focus) {
+            std::cout << "\nToo blurry (focus " << focus << " < " << min_focus << "), frame skipped" << std::endl;
+            return false;
         }
-        catch(const std::runtime_error &e) {
-            // Maybe timeout
-            std::cerr << "Get capture failed! msg=" << e.what() << std::endl;
+        return true;
+    };
+    do {
+        bool end = acq.closed();
+        stamped_capture c;
+        if(!acq.latest(c)) {
+            if(end) {
+                break;
+            }
+            // 没有新帧时也要处理窗口事件
+            key = cv::waitKey(1);
             continue;
         }
+        stats.queue.add(elapsed_ms(c.arrival));
 
         // Get color_image
-        std::shared_ptr<ob2::image> color_image = capture->get_color_image();
-
-        // Get depth_image
-        //std::shared_ptr<ob2::image> depth_image = capture->get_depth_image();
+        std::shared_ptr<ob2::image> color_image = c.capture->get_color_image();
 
-        // Get ir_image
-        //std::shared_ptr<ob2::image> ir_image = capture->get_ir_image();
-
-        // Render image
-        //win.render({ color_image, depth_image, ir_image }, RENDER_ONE_ROW);
-
-        auto mats = processImages({color_image});
-        cv::namedWindow("show", cv::WINDOW_NORMAL);
+        auto start = std::chrono::steady_clock::now();
+        auto mats = processImages({color_image}, pool);
+        cv::Mat ir;
+        if (stereo) {
+            auto ir_mats = processImages({c.capture->get_ir_image()}, pool);
+            if (!ir_mats.empty()) {
+                ir = ir_mats[0];
+                cv::imshow("ir", ir);
+            }
+        }
+        stats.convert.add(elapsed_ms(start));
         for (auto im : mats) {
-            cv::Mat tem;
-            im.copyTo(tem);
+            if(autocap) {
+                autocap->submit(im, color_image->get_device_timestamp_usec());
+            }
+            start = std::chrono::steady_clock::now();
+            cv::Mat tem = pool.acquire(im.size(), im.type());
+            if(undistort) {
+                if(!undistort->map.ready() || undistort->map.size() != im.size()) {
+                    undistort->map.prepare(undistort->K, undistort->dist, undistort->calib_size, im.size(), undistort->alpha, undistort->cache_path);
+                    std::cout << "Undistort map " << im.size().width << "x" << im.size().height;
+                    if(undistort->map.from_cache()) {
+                        std::cout << " loaded from " << undistort->cache_path << std::endl;
+                    }
+                    else {
+                        std::cout << " built in " << undistort->map.build_ms() << " ms" << std::endl;
+                    }
+                    stats.undistort_size = im.size();
+                }
+                auto remap_start = std::chrono::steady_clock::now();
+                undistort->map.apply(im, tem);
+                stats.undistort.add(elapsed_ms(remap_start));
+            }
+            else {
+                im.copyTo(tem);
+            }
             std::stringstream count_str;
             count_str << count;
             cv::putText(tem, count_str.str(), cv::Point(100, 200), cv::FONT_HERSHEY_SIMPLEX, 5, cv::Scalar(255, 0, 0), 5);
             cv::imshow("show", tem);
-            key = cv::waitKey(22);
+            key = cv::waitKey(1);
+            stats.display.add(elapsed_ms(start));
             // std::cout << key << std::endl;
             if ('q' == key) {
                 break;
             }
-            else if ('s' == key) {
-                std::ostringstream buff;
-                buff << "../imgs/" << count << ".jpg";
-                if (!cv::imwrite(buff.str(), im, std::vector<int>({cv::IMWRITE_JPEG_QUALITY, 100}))) {
-                    std::cout << "\nFail to write the file" << std::endl;
+            else if ('s' == key && !sharp_enough(im)) {
+                continue;
+            }
+            else if ('s' == key && pipeline) {
+                cv::Mat gray = pool.acquire(im.size(), CV_8UC1);
+                cv::cvtColor(im, gray, cv::COLOR_BGR2GRAY);
+                if (pipeline->push(gray, color_image->get_device_timestamp_usec(), true)) {
+                    ++count;
+                }
+            }
+            else if ('s' == key && stereo) {
+                if (ir.empty()) {
+                    std::cout << "\nNo IR image in this capture" << std::endl;
+                    continue;
+                }
+                std::stringstream color_name, ir_name;
+                color_name << count << "_color.jpg";
+                ir_name << count << "_ir.png";
+                if (saver.push_pair(im, color_name.str(), ir, ir_name.str())) {
+                    ++count;
                 }
                 else {
+                    std::cout << "\nSave queue is full, frame dropped" << std::endl;
+                }
+            }
+            else if ('s' == key) {
+                if (saver.push_next(im)) {
                     ++count;
                 }
+                else {
+                    std::cout << "\nSave queue is full, frame dropped" << std::endl;
+                }
             }
         }
     } while (!('q' == key || 'Q'== key));
+    if(autocap) {
+        autocap->stop();
+        autocap->print(std::cout);
+    }
+}
+
+int main(int argc, char **argv) TRY_EXECUTE {
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{stream    ||流水线模式：按下's'的帧直接送入检测线程，角点保存到该文件，不再保存图像}"
+        "{playback  ||从录制文件回放代替相机；同时指定 --stream 时不打开窗口，回放结束后自动退出}"
+        "{cols      |11|棋盘格列数}"
+        "{rows      |8|棋盘格行数}"
+        "{pyramid   |0|大于 0 时启用由粗到精检测，值为粗检测层的最大宽度}"
+        "{incremental i ||与 --stream 一起使用：每检测到一个有效棋盘格就增量重新标定，内参收敛后即可停止采集}"
+        "{tolerance |0.5|增量标定的收敛阈值，fx、fy、cx、cy 的变化量，单位：像素}"
+        "{stereo    ||同步采集彩色和 IR 图像，按下's'时成对保存到 ../imgs/stereo，出厂标定参数保存为 ../imgs/stereo/factory.yml}"
+        "{undistort ||calibrate 输出的内参文件，显示去畸变后的彩色图像，检测和保存的仍为原图}"
+        "{undistort_cache |../imgs/undistort.map|去畸变映射表的缓存文件，内参和分辨率不变时启动时直接读取，为空时不使用缓存}"
+        "{alpha     |0|去畸变的缩放系数，0 只保留有效像素，1 保留全部原始像素}"
+        "{auto a    ||自动采集：标定板静止、清晰且带来新位姿或新覆盖区域时自动保存（或送入检测线程），无需按's'}"
+        "{sharpness |100|自动采集的清晰度下限，标定板区域拉普拉斯响应的方差}"
+        "{novelty   |0.05|自动采集的位姿差异下限，按图像尺寸归一化}"
+        "{min_focus |0|大于 0 时整幅图像的清晰度低于该值的帧不保存也不检测（手动、自动采集和回放均适用），0 表示不筛选}");
+    if(parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    std::string corners_file = parser.get<std::string>("stream");
+    std::string playback_file = parser.get<std::string>("playback");
+    bool stereo = parser.has("stereo");
+    if(stereo && !corners_file.empty()) {
+        std::cout << "--stereo cannot be used with --stream" << std::endl;
+        return -1;
+    }
+    std::unique_ptr<auto_capture_options> auto_opt;
+    if(parser.has("auto")) {
+        if(stereo) {
+            std::cout << "--auto cannot be used with --stereo" << std::endl;
+            return -1;
+        }
+        auto_opt.reset(new auto_capture_options());
+        auto_opt->board_size = cv::Size(parser.get<int>("cols"), parser.get<int>("rows"));
+        auto_opt->min_sharpness = parser.get<double>("sharpness");
+        auto_opt->min_novelty = parser.get<double>("novelty");
+        auto_opt->min_focus = parser.get<double>("min_focus");
+    }
+    std::unique_ptr<undistort_stage> undistort;
+    std::string intrinsics_file = parser.get<std::string>("undistort");
+    if(!intrinsics_file.empty()) {
+        undistort.reset(new undistort_stage());
+        if(!load_intrinsics(intrinsics_file, undistort->K, undistort->dist, undistort->calib_size)) {
+            return -1;
+        }
+        undistort->alpha = parser.get<double>("alpha");
+        undistort->cache_path = parser.get<std::string>("undistort_cache");
+    }
+    detect_options opt;
+    opt.board_size = cv::Size(parser.get<int>("cols"), parser.get<int>("rows"));
+    opt.pyramid_width = parser.get<int>("pyramid");
+    opt.min_focus = parser.get<double>("min_focus");
+    frame_pool pool;
+    acquisition acq(4);
+    stream_stats stats;
+    double tolerance = parser.get<double>("tolerance");
+    // 物方点的尺度不影响内参，各视图共用单位边长的棋盘格
+    board_model unit_board(BOARD_CHESSBOARD, opt.board_size, 1.0f);
+    // 检测回调用到的对象都先于 pipeline 构造：异常退出时 pipeline 先析构，
+    // 其中 finish() 运行的回调不会访问已经销毁的对象
+    std::unique_ptr<incremental_calibrator> incremental;
+    std::unique_ptr<corner_pipeline> pipeline;
+    if(!corners_file.empty() && parser.has("incremental")) {
+        // 在检测线程中求解，显示与采集不受影响
+        pipeline.reset(new corner_pipeline(opt, 8, [&](const board_detection &det) {
+            if(!incremental) {
+                incremental.reset(new incremental_calibrator(det.im_size, tolerance));
+            }
+            bool was_converged = incremental->converged();
+            incremental->add_view(unit_board.view_points(det), det.corners);
+            incremental->print_progress(std::cout);
+            if(incremental->converged() && !was_converged) {
+                std::cout << "Intrinsics converged, press 'q' to stop capturing" << std::endl;
+            }
+        }));
+    }
+    else if(!corners_file.empty()) {
+        pipeline.reset(new corner_pipeline(opt, 8));
+    }
 
-    // Stop camera
-    dev->stop_cameras();
+    if(!playback_file.empty() && pipeline) {
+        runPlayback(playback_file, acq, *pipeline, pool, stats);
+        const std::vector<board_detection> &detections = pipeline->finish();
+        stats.print(acq);
+        std::cout << "Frame pool: " << pool.hits() << " hits, " << pool.misses() << " misses, " << pool.live_bytes() << " bytes live" << std::endl;
+        std::cout << "Valid boards: " << detections.size() << "/" << pipeline->submitted() << std::endl;
+        save_corners(corners_file, opt.board_size, pipeline->image_size(), detections);
+        return 0;
+    }
+
+    if(!playback_file.empty()) {
+        // 回放代替相机驱动显示循环，与相机一样在回放线程中采集，队列满时丢帧
+        ob2::playback pb(playback_file);
+        if(stereo) {
+            try {
+                save_stereo_params("../imgs/stereo/factory.yml", toStereoParams(pb.get_cameras_calibration()));
+            }
+            catch(const std::runtime_error &e) {
+                std::cout << "No cameras calibration in " << playback_file << ": " << e.what() << std::endl;
+            }
+        }
+        pb.start(
+            [&](std::shared_ptr<ob2::capture> capture) { acq.submit(capture, false); },
+            nullptr,
+            [&](ob2_playback_state_t state) {
+                if(state == OB2_PLAYBACK_END) {
+                    acq.close();
+                }
+            });
+        runDisplay(acq, pipeline.get(), pool, stats, stereo, undistort.get(), auto_opt.get(), opt.min_focus);
+        pb.stop();
+    }
+    else {
+        // Create context
+        auto ctx = std::make_shared<ob2::context>();
+
+        // Open default device
+        auto dev = ctx->open_device(OB2_DEFAULT_DEVICE);
+
+        // Open camera (use default configuration, the default configuration will open Color, Depth, Ir camera data stream)
+        // In stereo mode only Color and Ir are opened, and images in a capture are matched by device timestamp
+        std::shared_ptr<ob2::cameras_config> config = OB2_DEFAULT_CAMERAS_CONFIG;
+        if(stereo) {
+            config = dev->create_cameras_config();
+            config->enable_camera_stream(OB2_CAMERA_COLOR);
+            config->enable_camera_stream(OB2_CAMERA_IR);
+            config->set_images_sync_mode(OB2_IMAGES_SYNC_MODE_DEVICE_TIMESTAMP_MATCH);
+            save_stereo_params("../imgs/stereo/factory.yml", toStereoParams(dev->get_cameras_calibration(config)));
+        }
+
+        // Captures are delivered on the SDK thread and only queued there, so slow rendering never stalls acquisition
+        dev->start_cameras_with_callback(config, [&acq](std::shared_ptr<ob2::capture> capture) { acq.submit(capture, false); });
+
+        runDisplay(acq, pipeline.get(), pool, stats, stereo, undistort.get(), auto_opt.get(), opt.min_focus);
+
+        // Stop camera
+        dev->stop_cameras();
+    }
+
+    stats.print(acq);
+    std::cout << "Frame pool: " << pool.hits() << " hits, " << pool.misses() << " misses, " << pool.live_bytes() << " bytes live" << std::endl;
+
+    if(pipeline) {
+        const std::vector<board_detection> &detections = pipeline->finish();
+        std::cout << "Valid boards: " << detections.size() << "/" << pipeline->submitted() << std::endl;
+        save_corners(corners_file, opt.board_size, pipeline->image_size(), detections);
+    }
 
     return 0;
 }
@@ -3,52 +3,287 @@
 #include<sstream>
 #include<vector>
 #include<fstream>
+#include<string>
+#include<memory>
+#include<chrono>
 
-#define BOARD_COL 11 //棋盘格列数
-#define BOARD_ROW 8 //棋盘格行数
-#define SIDE_LENGTH 0.025 //格子边长，单位：m
+#include "hpp/board_model.hpp"
+#include "hpp/corner_detect.hpp"
+#include "hpp/corner_store.hpp"
+#include "hpp/overlay_writer.hpp"
+#include "hpp/incremental_calib.hpp"
+#include "hpp/outlier_rejection.hpp"
+#include "hpp/corner_cache.hpp"
+#include "hpp/schur_calib.hpp"
+#include "hpp/bootstrap.hpp"
+#include "hpp/view_selection.hpp"
+#include "hpp/undistort_map.hpp"
 
-int main()
+int main(int argc, char **argv)
 {
-    int count = 0;
-    std::vector<std::vector<cv::Point2f> > im_points;
-    std::vector<std::vector<cv::Point3f> > obj_points;
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{board     ||标定板描述文件（YAML），支持棋盘格、圆点阵列和 ChArUco，为空时使用 --cols、--rows、--side 描述的棋盘格}"
+        "{cols      |11|棋盘格列数}"
+        "{rows      |8|棋盘格行数}"
+        "{side      |0.025|格子边长，单位：m}"
+        "{partial   |6|ChArUco 标定板部分可见时至少检测到的角点数，达到该数量的视图也参与标定，0 表示只使用完整的标定板}"
+        "{threads j |0|角点检测线程数，0 表示使用全部核心}"
+        "{pyramid   |0|大于 0 时启用由粗到精检测，值为粗检测层的最大宽度，如 640}"
+        "{min_focus |0|大于 0 时先计算每张图像的清晰度，低于该值的模糊图像不做角点检测，0 表示不筛选}"
+        "{focus_step |2|清晰度评分的采样间隔，1 为逐像素}"
+        "{batch b   ||批处理模式，不打开任何窗口}"
+        "{overlay   ||角点标注图的输出目录，为空时不输出}"
+        "{corners   ||读取 grasp --stream 保存的角点文件，代替从图像中检测}"
+        "{incremental i ||增量标定：按顺序逐个加入有效视图并以上一次结果为初值重新求解，输出内参的收敛过程}"
+        "{tolerance |0.5|增量标定的收敛阈值，fx、fy、cx、cy 的变化量，单位：像素}"
+        "{cache     |../imgs/corner_cache.yml|角点缓存文件，图像内容和检测设置不变时跳过检测，为空时不使用缓存}"
+        "{solver    |opencv|最终求解使用的方法：opencv 为 calibrateCamera，schur 为消去位姿的稀疏求解器，视图较多时更快}"
+        "{bootstrap |0|大于 0 时用自助法重采样视图并重新标定该次数，给出内参和畸变系数的经验置信区间}"
+        "{confidence |0.95|自助法置信区间的置信度}"
+        "{select    |0|大于 0 时按信息量贪心选取最多该数量的视图参与求解}"
+        "{compare   ||与 --select 一起使用：再用全部视图求解一次，对比精度和耗时}"
+        "{reject    |0|大于 0 时自动剔除留一重投影误差超过该值（单位：像素）的视图}"
+        "{intrinsics |../intrinsics.yml|内参、畸变系数和图像尺寸的输出文件，grasp --undistort 读取该文件，为空时不输出}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    std::shared_ptr<board_model> board;
+    std::string board_file = parser.get<std::string>("board");
+    if (!board_file.empty()) {
+        board = board_model::load(board_file);
+        if (!board) {
+            return -1;
+        }
+    }
+    else {
+        board = std::make_shared<board_model>(BOARD_CHESSBOARD, cv::Size(parser.get<int>("cols"), parser.get<int>("rows")), parser.get<float>("side"));
+    }
+    detect_options opt;
+    board->configure(opt);
+    opt.min_partial = parser.get<int>("partial");
+    opt.threads = parser.get<int>("threads");
+    opt.pyramid_width = parser.get<int>("pyramid");
+    opt.min_focus = parser.get<double>("min_focus");
+    opt.focus_step = parser.get<int>("focus_step");
+    bool batch = parser.has("batch");
+    std::string overlay_dir = parser.get<std::string>("overlay");
+    std::unique_ptr<overlay_writer> writer;
+    if (!overlay_dir.empty()) {
+        writer.reset(new overlay_writer(overlay_dir, opt.board_size));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::string> paths;
+    std::vector<board_detection> detections;
+    std::string corners_file = parser.get<std::string>("corners");
     cv::Size im_size;
-    while (1) {
-        std::stringstream buffer;
-        buffer << "../imgs/" << count << ".jpg";
-        cv::Mat im = cv::imread(buffer.str());
-        ++count;
-        if (im.empty()) {
-            // std::cout << "Success in loading " << count << "picture" << std::endl;
-            break;
-        }
-        // std::cout << "Success in loading im" << count << std::endl;
-        im_size = im.size();
-        std::vector<cv::Point2f> corners;
-        if (!cv::findChessboardCornersSB(im, cv::Size(BOARD_COL, BOARD_ROW), corners, cv::CALIB_CB_EXHAUSTIVE | cv::CALIB_CB_ACCURACY)) {
+    if (!corners_file.empty() && board->type() != BOARD_CHESSBOARD) {
+        std::cout << "--corners only supports chessboard" << std::endl;
+        return -1;
+    }
+    if (!corners_file.empty()) {
+        // 角点文件中没有图像，不显示也不输出标注图
+        if (!load_corners(corners_file, opt.board_size, im_size, detections)) {
+            return -1;
+        }
+        batch = true;
+        writer.reset();
+    }
+    else {
+        paths = list_images("../imgs/");
+        std::string cache_file = parser.get<std::string>("cache");
+        if (!cache_file.empty()) {
+            corner_cache cache(cache_file, opt);
+            detections = cache.detect(paths);
+            cache.save();
+            std::cout << "Corner cache: " << cache.hits() << " hits, " << cache.misses() << " misses" << std::endl;
+        }
+        else {
+            detections = detect_boards(paths, opt);
+        }
+    }
+    double detect_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::vector<cv::Point2f> > im_points;
+    object_views obj_points;
+    std::vector<int> view_index;
+    // 完整与部分检测的视图数、角点数，以及其中靠近图像边缘的角点数
+    int full_views = 0, partial_views = 0;
+    int full_corners = 0, partial_corners = 0, full_edge = 0, partial_edge = 0;
+    // 因模糊被跳过的图像数，以及本次计算清晰度的图像数和总耗时（命中缓存的图像不重新计算）
+    int blurry = 0, focus_count = 0;
+    double focus_ms = 0;
+    for (auto &det : detections) {
+        if (!det.im_size.empty()) {
+            im_size = det.im_size;
+        }
+        if (det.focus >= 0 && det.focus < opt.min_focus) {
+            ++blurry;
+        }
+        if (det.focus_ms > 0) {
+            ++focus_count;
+            focus_ms += det.focus_ms;
+        }
+        if (!det.found) {
             // std::cout << "This image is invalid" << std::endl;
             continue;
         }
-        // std::cout << "Success in finding chessboard corners in im" << count << std::endl;
-        im_points.push_back(corners);
-        std::vector<cv::Point3f> obj_pt;
-        for (int i = 0; i < BOARD_ROW; ++i) {
-            for (int j = 0; j < BOARD_COL; ++j) {
-                obj_pt.push_back(cv::Point3f(i * SIDE_LENGTH, j * SIDE_LENGTH, 0));
+        im_points.push_back(det.corners);
+        obj_points.push_back(board->view_points(det));
+        view_index.push_back(det.index);
+        // 距图像边界不超过短边 10% 的角点视为边缘角点，这些区域对畸变系数的约束最强
+        float margin = 0.1f * std::min(im_size.width, im_size.height);
+        int edge = 0;
+        for (auto &p : det.corners) {
+            if (std::min(std::min(p.x, im_size.width - p.x), std::min(p.y, im_size.height - p.y)) < margin) {
+                ++edge;
+            }
+        }
+        if (det.ids.empty()) {
+            ++full_views;
+            full_corners += (int)det.corners.size();
+            full_edge += edge;
+        }
+        else {
+            ++partial_views;
+            partial_corners += (int)det.corners.size();
+            partial_edge += edge;
+        }
+        if (writer) {
+            writer->push(paths[det.index], det.index, det.corners, det.ids);
+        }
+        if (!batch) {
+            cv::Mat im = cv::imread(paths[det.index]);
+            draw_board_corners(im, opt.board_size, det.corners, det.ids);
+            cv::namedWindow("out", cv::WINDOW_NORMAL);
+            cv::imshow("out", im);
+            cv::waitKey(0);
+        }
+    }
+    if (opt.min_focus > 0) {
+        std::cout << "Focus gate: " << blurry << "/" << detections.size() << " images skipped as blurry, avg "
+                  << (focus_count ? focus_ms / focus_count : 0) << " ms per image" << std::endl;
+    }
+    if (partial_views > 0) {
+        std::cout << "Partial boards: +" << partial_views << " views (" << full_views << " full), +" << partial_corners << " corners ("
+                  << full_corners << " full), +" << partial_edge << " edge corners (" << full_edge << " full)" << std::endl;
+    }
+    double reject_threshold = parser.get<double>("reject");
+    if (reject_threshold > 0) {
+        rejection_options reject_opt;
+        reject_opt.threshold = reject_threshold;
+        reject_opt.threads = opt.threads;
+        rejection_result rejected = reject_outlier_views(obj_points, im_points, im_size, reject_opt);
+        std::cout << "Outlier rejection: " << rejected.dropped.size() << " views dropped in " << rejected.rounds << " rounds, "
+                  << rejected.solves << " leave-one-out solves, " << rejected.elapsed_ms << " ms" << std::endl;
+        for (size_t k = 0; k < rejected.dropped.size(); ++k) {
+            std::cout << "  dropped " << view_index[rejected.dropped[k]] << ".jpg, held-out error " << rejected.scores[k] << " px" << std::endl;
+        }
+        std::vector<std::vector<cv::Point2f> > kept_im;
+        object_views kept_obj;
+        std::vector<int> kept_index;
+        for (int k : rejected.kept) {
+            kept_im.push_back(im_points[k]);
+            kept_obj.push_back(obj_points[k]);
+            kept_index.push_back(view_index[k]);
+        }
+        im_points.swap(kept_im);
+        obj_points.swap(kept_obj);
+        view_index.swap(kept_index);
+    }
+
+    // 未被选中的视图，用于评估子集求解结果的精度
+    std::vector<std::vector<cv::Point2f> > rest_im;
+    object_views rest_obj;
+    std::vector<std::vector<cv::Point2f> > all_im = im_points;
+    object_views all_obj = obj_points;
+    int budget = parser.get<int>("select");
+    if (budget > 0) {
+        selection_options select_opt;
+        select_opt.budget = budget;
+        select_opt.threads = opt.threads;
+        selection_result selection = select_views(obj_points, im_points, im_size, select_opt);
+        std::vector<char> chosen(im_points.size(), 0);
+        std::vector<std::vector<cv::Point2f> > sel_im;
+        object_views sel_obj;
+        std::vector<int> sel_index;
+        std::cout << "View selection: " << selection.selected.size() << "/" << im_points.size() << " views, coverage " << selection.coverage * 100 << "%, "
+                  << selection.elapsed_ms << " ms\n  selected:";
+        for (int k : selection.selected) {
+            chosen[k] = 1;
+            sel_im.push_back(im_points[k]);
+            sel_obj.push_back(obj_points[k]);
+            sel_index.push_back(view_index[k]);
+            std::cout << " " << view_index[k] << ".jpg";
+        }
+        std::cout << std::endl;
+        for (size_t k = 0; k < im_points.size(); ++k) {
+            if (!chosen[k]) {
+                rest_im.push_back(im_points[k]);
+                rest_obj.push_back(obj_points[k]);
+            }
+        }
+        im_points.swap(sel_im);
+        obj_points.swap(sel_obj);
+        view_index.swap(sel_index);
+    }
+
+    start = std::chrono::steady_clock::now();
+    std::unique_ptr<incremental_calibrator> incremental;
+    if (parser.has("incremental")) {
+        incremental.reset(new incremental_calibrator(im_size, parser.get<double>("tolerance")));
+        int converged_at = 0;
+        for (size_t k = 0; k < im_points.size(); ++k) {
+            incremental->add_view(obj_points[k], im_points[k]);
+            incremental->print_progress(std::cout);
+            if (incremental->converged() && converged_at == 0) {
+                converged_at = incremental->views();
             }
         }
-        obj_points.push_back(obj_pt);
-        drawChessboardCorners(im, cv::Size(BOARD_COL, BOARD_ROW), corners, true);
-        cv::namedWindow("out", cv::WINDOW_NORMAL);
-        cv::imshow("out", im);
-        cv::waitKey(0);
-    }
-    cv::Mat cam_mat, dist;
-    std::vector<cv::Mat> rvecs, tvecs, rmat;
-    cv::Mat cam_deviation, dist_deviation;
-    std::vector<double> error;
-    cv::calibrateCamera(obj_points, im_points, im_size, cam_mat, dist, rvecs, tvecs, cam_deviation, dist_deviation, error, 0, cv::TermCriteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 50, 1e-12));
+        if (converged_at > 0) {
+            std::cout << "Converged after " << converged_at << " views" << std::endl;
+        }
+        else {
+            std::cout << "Not converged, more views are needed" << std::endl;
+        }
+    }
+    // 最终结果使用全部视图求解，增量标定时以最后一次的结果为初值
+    cv::TermCriteria criteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 50, 1e-12);
+    std::string solver = parser.get<std::string>("solver");
+    calib_result r;
+    if (solver == "schur") {
+        r = calibrate_views_schur(obj_points, im_points, im_size, incremental ? &incremental->result() : nullptr, criteria, opt.threads);
+    }
+    else if (solver == "opencv") {
+        r = calibrate_views(obj_points, im_points, im_size, incremental ? &incremental->result() : nullptr, criteria);
+    }
+    else {
+        std::cout << "Unknown solver " << solver << std::endl;
+        return -1;
+    }
+    cv::Mat &cam_mat = r.cam_mat, &dist = r.dist;
+    cv::Mat &cam_deviation = r.cam_deviation;
+    std::vector<double> &error = r.error;
+    double solve_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Valid images: " << im_points.size() << "/" << detections.size() << ", detection " << detect_sec << " s, calibration " << solve_sec << " s" << std::endl;
+    if (!rest_im.empty()) {
+        double held_out = 0;
+        for (size_t k = 0; k < rest_im.size(); ++k) {
+            held_out += held_out_error(r, rest_obj[k], rest_im[k]);
+        }
+        std::cout << "Unselected views: " << rest_im.size() << ", average re-projection error " << held_out / rest_im.size() << " px" << std::endl;
+        if (parser.has("compare")) {
+            calib_result all = solver == "schur" ? calibrate_views_schur(all_obj, all_im, im_size, nullptr, criteria, opt.threads)
+                                                 : calibrate_views(all_obj, all_im, im_size, nullptr, criteria);
+            std::cout << "All " << all_im.size() << " views: " << all.solve_ms / 1000 << " s (subset " << r.solve_ms / 1000 << " s), rms " << all.rms
+                      << " (subset " << r.rms << ")\n  subset - all: fx " << r.cam_mat.at<double>(0, 0) - all.cam_mat.at<double>(0, 0)
+                      << ", fy " << r.cam_mat.at<double>(1, 1) - all.cam_mat.at<double>(1, 1) << ", cx " << r.cam_mat.at<double>(0, 2) - all.cam_mat.at<double>(0, 2)
+                      << ", cy " << r.cam_mat.at<double>(1, 2) - all.cam_mat.at<double>(1, 2) << " px" << std::endl;
+        }
+    }
     std::stringstream buffer;
     buffer << "Camera Matrix =\n";
     for (int i = 0; i < 3; ++i) {
@@ -62,16 +297,15 @@ int main()
         buffer << dist.at<double>(0, i) << " ";
     }
     buffer << "\n";
-    buffer << "Camera Matrix Deviation =\n";
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            buffer << cam_deviation.at<double>(i, j) << " ";
-        }
-        buffer << "\n";
+    // cam_deviation 为 fx fy cx cy k1 k2 p1 p2 k3 ... 排成的列向量
+    buffer << "Intrinsics Deviation (fx fy cx cy) =\n";
+    for (int i = 0; i < 4; ++i) {
+        buffer << cam_deviation.at<double>(i) << " ";
     }
+    buffer << "\n";
     buffer << "Dist Coeffs Deviation =\n";
     for (int i = 0; i < 5; ++i) {
-        buffer << dist_deviation.at<double>(0, i) << " ";
+        buffer << cam_deviation.at<double>(4 + i) << " ";
     }
     buffer << "\n";
     buffer << "Re-projection Error:\n";
@@ -84,11 +318,24 @@ int main()
     }
     buffer << "\n";
     buffer << "Average Error = " << total_err / err_count;
+    int bootstrap_samples = parser.get<int>("bootstrap");
+    if (bootstrap_samples > 0) {
+        bootstrap_result boot = bootstrap_intrinsics(obj_points, im_points, im_size, r, bootstrap_samples, parser.get<double>("confidence"), solver == "schur", opt.threads);
+        buffer << "\nBootstrap (" << boot.samples << " samples, " << boot.confidence * 100 << "% interval, " << boot.elapsed_ms << " ms):";
+        for (int p = 0; p < BOOTSTRAP_PARAMS; ++p) {
+            const bootstrap_interval &iv = boot.params[p];
+            buffer << "\n" << BOOTSTRAP_NAMES[p] << " = " << iv.mean << " ± " << iv.std << " [" << iv.lo << ", " << iv.hi << "]";
+        }
+    }
     std::cout << buffer.str() << std::endl;
     std::ofstream out("../result.txt");
     if (!out.is_open()) {
         std::cout << "Fail to open result.txt" << std::endl;
     }
     out << buffer.str() << std::endl;
+    std::string intrinsics_file = parser.get<std::string>("intrinsics");
+    if (!intrinsics_file.empty()) {
+        save_intrinsics(intrinsics_file, cam_mat, dist, im_size);
+    }
     return 0;
 }
\ No newline at end of file
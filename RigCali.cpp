@@ -0,0 +1,312 @@
+#include "hpp/OB2Context.hpp"
+#include "hpp/OB2Playback.hpp"
+#include "hpp/preheader.hpp"
+#include "hpp/image_view.hpp"
+#include "hpp/frame_pool.hpp"
+#include "hpp/board_model.hpp"
+#include "hpp/corner_order.hpp"
+#include "hpp/corner_pipeline.hpp"
+#include "hpp/rig_calib.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <string>
+#include <thread>
+
+// 多相机联合标定：同时从多台设备（或代替设备的多个录制文件）采集彩色图像，每台设备有各自的检测线程，
+// 按时间戳匹配各设备的检测结果后联合求解全部内参及各相机相对相机 0 的外参
+
+// 一台设备或代替它的录制文件
+struct rig_device {
+    std::string name;  // 序列号或录制文件路径
+    std::shared_ptr<ob2::device> dev;
+    std::unique_ptr<ob2::playback> pb;
+    std::unique_ptr<corner_pipeline> pipeline;
+    frame_pool pool;
+    int64_t last_tick = -1;
+    std::atomic<bool> ended{false};
+    std::atomic<uint64_t> reached{0};  // 参考设备：已收到的最新一帧的时间戳
+    // 非参考设备：参考设备抽中的帧的时间戳，按顺序等待本设备取时间戳最接近的一帧
+    std::mutex target_mutex;
+    std::deque<uint64_t> targets;
+    // 非参考设备最近收到的几帧，只在本设备的回调线程中访问
+    std::deque<std::pair<uint64_t, std::shared_ptr<ob2::image> > > recent;
+    uint64_t last_submitted = 0;
+
+    // 成员按声明的逆序析构，pipeline 和 pool 先于 dev、pb 销毁；先停止采集，回调不再访问它们
+    ~rig_device() {
+        stop();
+    }
+
+    // 可重复调用，只在异常退出的清理路径上使用，不抛出异常
+    void stop() noexcept {
+        // 等待参考设备的回放回调以 ended 为退出条件
+        ended = true;
+        try {
+            if(pb) {
+                pb->stop();
+            }
+            if(dev) {
+                dev->stop_cameras();
+            }
+        }
+        catch(...) {
+        }
+    }
+};
+
+// 彩色图像直接转换为灰度图，不经过 BGR
+cv::Mat colorToGray(std::shared_ptr<ob2::image> im, frame_pool &pool) {
+    image_view view(im);
+    cv::Mat gray = pool.acquire(cv::Size(im->get_width_pixels(), im->get_height_pixels()), CV_8UC1);
+    switch(im->get_format()) {
+    case OB2_FORMAT_MJPG:
+        cv::imdecode(view.mat(), cv::IMREAD_GRAYSCALE, &gray);
+        break;
+    case OB2_FORMAT_YUYV:
+        cv::cvtColor(view.mat(), gray, cv::COLOR_YUV2GRAY_YUYV);
+        break;
+    case OB2_FORMAT_NV12:
+        cv::cvtColor(view.mat(), gray, cv::COLOR_YUV2GRAY_NV12);
+        break;
+    case OB2_FORMAT_RGB:
+        cv::cvtColor(view.mat(), gray, cv::COLOR_RGB2GRAY);
+        break;
+    default:
+        gray.release();
+        break;
+    }
+    return gray;
+}
+
+std::vector<std::string> splitList(const std::string &s) {
+    std::vector<std::string> items;
+    std::stringstream in(s);
+    std::string item;
+    while(std::getline(in, item, ',')) {
+        if(!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char **argv) TRY_EXECUTE {
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{serials   ||逗号分隔的设备序列号，第一个为参考相机；为空时打开全部已连接的设备}"
+        "{playback  ||逗号分隔的录制文件，每个文件代替一台设备，各文件须为同时录制}"
+        "{duration  |30|实时采集的时长，单位：s，按任意键可提前结束；回放时读完全部文件即结束}"
+        "{interval  |500|参考设备每隔该时长取一帧送入检测，其他设备取时间戳与之最接近的一帧，单位：ms}"
+        "{sync      |20|时间戳相差不超过该值的检测视为同一时刻，单位：ms；没有硬件同步时最接近的两帧至多相差半个帧间隔（30 fps 时约 17 ms）}"
+        "{clock     |system|匹配使用的时间戳：system 为主机接收时间，device 为设备时间戳（仅在设备间有硬件同步时使用）}"
+        "{board     ||标定板描述文件（YAML），为空时使用 --cols、--rows、--side 描述的棋盘格}"
+        "{cols      |11|棋盘格列数}"
+        "{rows      |8|棋盘格行数}"
+        "{side      |0.025|格子边长，单位：m}"
+        "{partial   |6|ChArUco 标定板部分可见时至少检测到的角点数，0 表示只使用完整的标定板}"
+        "{threads j |0|联合求解的线程数，0 表示使用全部核心}"
+        "{output    |../rig_result.yml|标定结果的输出文件}");
+    if(parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    std::shared_ptr<board_model> board;
+    std::string board_file = parser.get<std::string>("board");
+    if(!board_file.empty()) {
+        board = board_model::load(board_file);
+        if(!board) {
+            return -1;
+        }
+    }
+    else {
+        board = std::make_shared<board_model>(BOARD_CHESSBOARD, cv::Size(parser.get<int>("cols"), parser.get<int>("rows")), parser.get<float>("side"));
+    }
+    detect_options opt;
+    board->configure(opt);
+    opt.min_partial = parser.get<int>("partial");
+    // 每台设备独占一个检测线程，检测内部不再并行
+    opt.threads = 1;
+
+    std::vector<std::string> files = splitList(parser.get<std::string>("playback"));
+    std::vector<std::string> serials = splitList(parser.get<std::string>("serials"));
+    std::shared_ptr<ob2::context> ctx;
+    if(files.empty() && serials.empty()) {
+        ctx = std::make_shared<ob2::context>();
+        for(auto &info: ctx->get_installed_device_info_list()) {
+            serials.push_back(info.serial_number);
+        }
+    }
+    const bool playback = !files.empty();
+    const size_t n_dev = playback ? files.size() : serials.size();
+    if(n_dev < 2) {
+        std::cout << "At least 2 devices or playback files are needed, got " << n_dev << std::endl;
+        return -1;
+    }
+
+    const int64_t interval_usec = (int64_t)parser.get<int>("interval") * 1000;
+    const bool device_clock = parser.get<std::string>("clock") == "device";
+    std::vector<std::unique_ptr<rig_device> > devices;
+    for(size_t i = 0; i < n_dev; ++i) {
+        std::unique_ptr<rig_device> d(new rig_device());
+        d->name = playback ? files[i] : serials[i];
+        d->pipeline.reset(new corner_pipeline(opt, 4));
+        devices.push_back(std::move(d));
+    }
+
+    auto submit = [&](rig_device &d, const std::shared_ptr<ob2::image> &im, uint64_t t) {
+        cv::Mat gray = colorToGray(im, d.pool);
+        if(!gray.empty()) {
+            d.pipeline->push(gray, t, playback);
+        }
+    };
+
+    // 在各设备的回调线程中抽帧并转换，实时采集时检测跟不上则丢帧，回放时等待而不丢帧。
+    // 参考设备按时间间隔抽帧，其他设备不各自按区间抽帧（各设备的帧相位不同，区间边界后的第一帧可能相差近一帧），
+    // 而是取时间戳与参考设备抽中的帧最接近的一帧，检测结果才能在 --sync 内匹配
+    auto on_capture = [&](rig_device &d, std::shared_ptr<ob2::capture> capture) {
+        std::shared_ptr<ob2::image> im = capture->get_color_image();
+        if(im == nullptr) {
+            return;
+        }
+        uint64_t t = device_clock ? im->get_device_timestamp_usec() : im->get_system_timestamp_usec();
+        rig_device &ref = *devices[0];
+        if(&d == &ref) {
+            ref.reached = t;
+            int64_t tick = interval_usec > 0 ? (int64_t)t / interval_usec : (int64_t)t;
+            if(tick == d.last_tick) {
+                return;
+            }
+            d.last_tick = tick;
+            for(size_t i = 1; i < devices.size(); ++i) {
+                std::lock_guard<std::mutex> lock(devices[i]->target_mutex);
+                devices[i]->targets.push_back(t);
+            }
+            submit(d, im, t);
+            return;
+        }
+        // 回放时各文件读取的快慢不同，先等参考设备读到同一时刻，避免本设备的帧在目标到来之前就已经过去
+        while(playback && ref.reached < t && !ref.ended) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        d.recent.push_back(std::make_pair(t, im));
+        if(d.recent.size() > 4) {
+            d.recent.pop_front();
+        }
+        // 收到时间戳不早于目标的帧后，之后的帧只会更远，在最近几帧中取最接近的一帧
+        std::vector<uint64_t> due;
+        {
+            std::lock_guard<std::mutex> lock(d.target_mutex);
+            while(!d.targets.empty() && t >= d.targets.front()) {
+                due.push_back(d.targets.front());
+                d.targets.pop_front();
+            }
+        }
+        for(uint64_t target: due) {
+            auto nearest = d.recent.begin();
+            for(auto it = d.recent.begin(); it != d.recent.end(); ++it) {
+                if(std::llabs((int64_t)(it->first - target)) < std::llabs((int64_t)(nearest->first - target))) {
+                    nearest = it;
+                }
+            }
+            if(nearest->first != d.last_submitted) {
+                d.last_submitted = nearest->first;
+                submit(d, nearest->second, nearest->first);
+            }
+        }
+    };
+
+    // 设备 k 打开或启动失败时，已启动的设备仍在回调中使用 on_capture 和参考设备；
+    // 先于它们析构，把全部设备停止之后才销毁这些对象
+    struct stop_devices {
+        std::vector<std::unique_ptr<rig_device> > &devices;
+        ~stop_devices() {
+            for(auto &d: devices) {
+                d->stop();
+            }
+        }
+    } guard{devices};
+
+    if(playback) {
+        for(auto &d: devices) {
+            rig_device *dp = d.get();
+            d->pb.reset(new ob2::playback(d->name));
+            d->pb->start([&on_capture, dp](std::shared_ptr<ob2::capture> capture) { on_capture(*dp, capture); }, nullptr,
+                         [dp](ob2_playback_state_t state) {
+                             if(state == OB2_PLAYBACK_END) {
+                                 dp->ended = true;
+                             }
+                         });
+        }
+        for(auto &d: devices) {
+            while(!d->ended) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            d->pb->stop();
+        }
+    }
+    else {
+        if(!ctx) {
+            ctx = std::make_shared<ob2::context>();
+        }
+        for(auto &d: devices) {
+            rig_device *dp = d.get();
+            d->dev = ctx->open_device_by_serial_number(d->name);
+            auto config = d->dev->create_cameras_config();
+            config->enable_camera_stream(OB2_CAMERA_COLOR);
+            d->dev->start_cameras_with_callback(config, [&on_capture, dp](std::shared_ptr<ob2::capture> capture) { on_capture(*dp, capture); });
+        }
+        std::cout << "Capturing from " << n_dev << " devices, move the board through the shared field of view; press any key to stop" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        double duration = parser.get<double>("duration");
+        while(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < duration && !_kbhit()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        for(auto &d: devices) {
+            d->dev->stop_cameras();
+        }
+    }
+
+    std::vector<std::vector<board_detection> > detections;
+    std::vector<cv::Size> im_sizes;
+    std::vector<std::string> names;
+    for(auto &d: devices) {
+        detections.push_back(d->pipeline->finish());
+        im_sizes.push_back(d->pipeline->image_size());
+        names.push_back(d->name);
+        std::cout << "Camera " << names.size() - 1 << " (" << d->name << "): " << detections.back().size() << " boards in " << d->pipeline->submitted()
+                  << " frames, " << d->pipeline->dropped() << " dropped" << std::endl;
+    }
+
+    std::vector<rig_view> views = match_rig_views(detections, *board, (uint64_t)(parser.get<double>("sync") * 1000));
+    // 对称的标定板在各相机中可能从不同的角开始排列，联合标定前统一为同一顺序，与其他观测矛盾的检测不参与标定
+    int disagree = align_corner_orders(views, *board, im_sizes);
+    if(disagree > 0) {
+        std::cout << "Corner order of " << disagree << " detections disagrees with the other cameras, dropped" << std::endl;
+    }
+    rig_result res;
+    const cv::TermCriteria criteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 50, 1e-12);
+    if(!calibrate_rig(views, im_sizes, criteria, parser.get<int>("threads"), res)) {
+        return -1;
+    }
+    std::cout << "Views: " << views.size() << ", shared by 2+ cameras: " << res.shared_views << std::endl;
+    std::cout << "Joint calibration " << res.solve_ms << " ms, " << res.iterations << " iterations, rms = " << res.rms << std::endl;
+    for(size_t c = 0; c < res.cameras.size(); ++c) {
+        const rig_camera &cam = res.cameras[c];
+        std::cout << "Camera " << c << " (" << names[c] << "): " << cam.views << " views, rms = " << cam.rms << "\nCamera Matrix =\n"
+                  << cam.K << "\nDist Coeffs =\n" << cam.dist << std::endl;
+        if(c > 0) {
+            std::cout << "Rotation from camera 0 =\n" << cam.R << "\nTranslation from camera 0 (mm) =\n" << cam.T << std::endl;
+        }
+    }
+    save_rig_params(parser.get<std::string>("output"), res, names);
+    return 0;
+}
+CATCH_EXCEPTIONS()
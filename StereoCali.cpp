@@ -0,0 +1,117 @@
+#include<opencv2/opencv.hpp>
+#include<chrono>
+#include<fstream>
+#include<iostream>
+#include<string>
+#include<vector>
+
+#include "hpp/board_model.hpp"
+#include "hpp/corner_detect.hpp"
+#include "hpp/corner_order.hpp"
+#include "hpp/incremental_calib.hpp"
+#include "hpp/stereo_calib.hpp"
+
+// 一对同步图像的检测，相机 0 为彩色，相机 1 为 IR
+struct stereo_view {
+    std::vector<int> cameras;
+    object_views obj_points;
+    std::vector<std::vector<cv::Point2f> > im_points;
+};
+
+// IR 到彩色相机的外参标定：读取 grasp --stereo 成对保存的图像，求解 IR 内参及 IR 到彩色的旋转平移，并与出厂参数对比
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{dir       |../imgs/stereo/|图像目录，图像按 N_color.jpg, N_ir.png 成对命名}"
+        "{factory   |../imgs/stereo/factory.yml|grasp --stereo 保存的出厂标定参数，文件不存在时不对比}"
+        "{output    |../stereo_result.yml|标定结果的输出文件}"
+        "{cols      |11|棋盘格列数}"
+        "{rows      |8|棋盘格行数}"
+        "{side      |0.025|格子边长，单位：m}"
+        "{threads j |0|角点检测线程数，0 表示使用全部核心}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    std::string dir = parser.get<std::string>("dir");
+    if (!dir.empty() && dir.back() != '/') {
+        dir += '/';
+    }
+    detect_options opt;
+    opt.board_size = cv::Size(parser.get<int>("cols"), parser.get<int>("rows"));
+    opt.threads = parser.get<int>("threads");
+
+    std::vector<std::string> color_paths, ir_paths;
+    list_stereo_pairs(dir, color_paths, ir_paths);
+    if (color_paths.empty()) {
+        std::cout << "No image pair found in " << dir << std::endl;
+        return -1;
+    }
+
+    // 两路图像放在同一个列表中一起并行检测，前一半为彩色，后一半为 IR
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> paths = color_paths;
+    paths.insert(paths.end(), ir_paths.begin(), ir_paths.end());
+    std::vector<board_detection> detections = detect_boards(paths, opt);
+    double detect_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const size_t n = color_paths.size();
+    board_model board(BOARD_CHESSBOARD, opt.board_size, parser.get<float>("side"));
+    std::vector<stereo_view> pairs;
+    cv::Size color_size, ir_size;
+    for (size_t i = 0; i < n; ++i) {
+        const board_detection &color = detections[i];
+        const board_detection &ir = detections[n + i];
+        if (!color.im_size.empty()) {
+            color_size = color.im_size;
+        }
+        if (!ir.im_size.empty()) {
+            ir_size = ir.im_size;
+        }
+        // 两路都找到完整棋盘格的图像对才能用于外参标定
+        if (!color.found || !ir.found) {
+            continue;
+        }
+        stereo_view v;
+        v.cameras = {0, 1};
+        v.obj_points = {board.view_points(color), board.view_points(ir)};
+        v.im_points = {color.corners, ir.corners};
+        pairs.push_back(v);
+    }
+    // 两路检测共用物方点之前先统一角点顺序，顺序无法与其他图像对一致的图像对不参与外参标定
+    int disagree = align_corner_orders(pairs, board, {color_size, ir_size});
+    object_views obj_points;
+    std::vector<std::vector<cv::Point2f> > color_points, ir_points;
+    for (const stereo_view &v : pairs) {
+        if (v.cameras.size() == 2) {
+            obj_points.push_back(v.obj_points[0]);
+            color_points.push_back(v.im_points[0]);
+            ir_points.push_back(v.im_points[1]);
+        }
+    }
+    if (disagree > 0) {
+        std::cout << "Corner order of " << disagree << " pairs disagrees with the others, dropped" << std::endl;
+    }
+    std::cout << "Valid pairs: " << obj_points.size() << "/" << n << ", detection " << detect_sec << " s" << std::endl;
+    if (obj_points.size() < 3) {
+        std::cout << "At least 3 valid pairs are needed" << std::endl;
+        return -1;
+    }
+
+    stereo_result res = calibrate_stereo(obj_points, ir_points, color_points, ir_size, color_size);
+    const stereo_params &p = res.params;
+    std::cout << "Calibration " << res.solve_ms / 1000 << " s, stereo rms = " << res.rms << " (IR " << res.ir_rms << ", color " << res.color_rms << ")"
+              << std::endl;
+    std::cout << "IR Camera Matrix =\n" << p.ir_K << "\nIR Dist Coeffs =\n" << p.ir_dist << std::endl;
+    std::cout << "Color Camera Matrix =\n" << p.color_K << "\nColor Dist Coeffs =\n" << p.color_dist << std::endl;
+    std::cout << "IR to Color Rotation =\n" << p.R << "\nIR to Color Translation (mm) =\n" << p.T << std::endl;
+    save_stereo_params(parser.get<std::string>("output"), p);
+
+    std::string factory_file = parser.get<std::string>("factory");
+    stereo_params factory;
+    if (std::ifstream(factory_file).good() && load_stereo_params(factory_file, factory)) {
+        print_stereo_drift(std::cout, p, factory);
+    }
+    return 0;
+}
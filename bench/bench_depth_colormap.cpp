@@ -0,0 +1,54 @@
+#include<opencv2/opencv.hpp>
+#include<chrono>
+#include<iostream>
+#include<vector>
+
+#include "hpp/depth_colormap.hpp"
+
+// 对比原先的缩放 + convertTo + applyColorMap 三遍处理与单遍 depth_colormap 的耗时
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{frames    |200|每种分辨率测试的帧数}"
+        "{scale     |1|深度值单位，即 get_value_scale()}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    int frames = parser.get<int>("frames");
+    float scale = parser.get<float>("scale");
+    depth_colormap colormap(0, 6000);
+    std::vector<cv::Size> sizes = {cv::Size(640, 480), cv::Size(1280, 800)};
+    for (auto size : sizes) {
+        cv::Mat depth(size, CV_16UC1);
+        cv::randu(depth, 0, 8000 / scale);
+        cv::Mat ref, out;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            ref = depth * 255 / (6000 / scale);
+            ref.convertTo(ref, CV_8UC1);
+            cv::applyColorMap(ref, ref, cv::COLORMAP_JET);
+        }
+        double three_pass_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            colormap.apply_scalar(depth, scale, out);
+        }
+        double scalar_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            colormap.apply(depth, scale, out);
+        }
+        double simd_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        // 原先的实现四舍五入，这里向下取整，索引最多相差 1
+        double max_diff = cv::norm(ref, out, cv::NORM_INF);
+        std::cout << size.width << "x" << size.height << ": three-pass " << three_pass_ms << " ms, fused scalar " << scalar_ms
+                  << " ms, fused SIMD " << simd_ms << " ms, max channel diff " << max_diff << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include<opencv2/opencv.hpp>
+#include<algorithm>
+#include<chrono>
+#include<iostream>
+#include<thread>
+#include<vector>
+
+#include "hpp/corner_detect.hpp"
+
+// 测试不同线程数下角点检测的吞吐量（张/秒）
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{dir       |../imgs/|图像目录，图像按 0.jpg, 1.jpg ... 命名}"
+        "{cols      |11|棋盘格列数}"
+        "{rows      |8|棋盘格行数}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    std::vector<std::string> paths = list_images(parser.get<std::string>("dir"));
+    if (paths.empty()) {
+        std::cout << "No image found in " << parser.get<std::string>("dir") << std::endl;
+        return -1;
+    }
+    detect_options opt;
+    opt.board_size = cv::Size(parser.get<int>("cols"), parser.get<int>("rows"));
+
+    int hw = resolve_threads(0);
+    std::vector<int> thread_counts = {1, 2, 4, hw};
+    std::sort(thread_counts.begin(), thread_counts.end());
+    thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()), thread_counts.end());
+
+    std::cout << paths.size() << " images, " << hw << " hardware threads" << std::endl;
+    double base_rate = 0;
+    for (int threads : thread_counts) {
+        opt.threads = threads;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<board_detection> detections = detect_boards(paths, opt);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int found = (int)std::count_if(detections.begin(), detections.end(), [](const board_detection &det) { return det.found; });
+        double rate = paths.size() / sec;
+        if (threads == 1) {
+            base_rate = rate;
+        }
+        std::cout << "threads = " << threads << "\t" << rate << " images/sec\tspeedup = " << rate / base_rate << "\tvalid = " << found << std::endl;
+    }
+    return 0;
+}
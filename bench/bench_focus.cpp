@@ -0,0 +1,81 @@
+#include<opencv2/opencv.hpp>
+#include<chrono>
+#include<iostream>
+#include<algorithm>
+
+#include "hpp/focus_measure.hpp"
+
+// 清晰度评分的耗时与区分度：在合成的棋盘格图像上施加不同程度的高斯模糊，
+// 对比 cv::Laplacian + meanStdDev 与 focus_measure（step 为 1、2）的评分和单帧耗时，耗时目标为 1080p 下 1 ms
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{frames    |200|每种方法测试的帧数}"
+        "{width     |1920|图像宽度}"
+        "{height    |1080|图像高度}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    int frames = parser.get<int>("frames");
+    cv::Size size(parser.get<int>("width"), parser.get<int>("height"));
+    const double target_ms = 1;
+
+    // 12x9 个格子的棋盘格占画面中央约 80%，叠加少量噪声模拟传感器
+    cv::Mat sharp(size, CV_8UC1, cv::Scalar(128));
+    int square = std::min(size.width * 8 / 10 / 12, size.height * 8 / 10 / 9);
+    cv::Point origin((size.width - 12 * square) / 2, (size.height - 9 * square) / 2);
+    for (int r = 0; r < 9; ++r) {
+        for (int c = 0; c < 12; ++c) {
+            cv::rectangle(sharp, cv::Rect(origin.x + c * square, origin.y + r * square, square, square), cv::Scalar((r + c) % 2 ? 230 : 25), cv::FILLED);
+        }
+    }
+    cv::Mat noise(size, CV_8UC1);
+    cv::randn(noise, 0, 2);
+    cv::add(sharp, noise, sharp);
+
+    std::cout << "sigma   laplacian   step=1   step=2" << std::endl;
+    for (double sigma : {0.0, 1.0, 2.0, 4.0, 8.0}) {
+        cv::Mat blurred = sharp;
+        if (sigma > 0) {
+            cv::GaussianBlur(sharp, blurred, cv::Size(), sigma);
+        }
+        cv::Mat lap;
+        cv::Laplacian(blurred, lap, CV_16S);
+        cv::Scalar mean, stddev;
+        cv::meanStdDev(lap, mean, stddev);
+        std::cout << sigma << "   " << stddev[0] * stddev[0] << "   " << focus_measure(blurred, 1) << "   " << focus_measure(blurred, 2) << std::endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    double sink = 0;
+    for (int i = 0; i < frames; ++i) {
+        cv::Mat lap;
+        cv::Laplacian(sharp, lap, CV_16S);
+        cv::Scalar mean, stddev;
+        cv::meanStdDev(lap, mean, stddev);
+        sink += stddev[0];
+    }
+    double reference_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    std::cout << size.width << "x" << size.height << ": Laplacian + meanStdDev " << reference_ms << " ms";
+    for (int step : {1, 2}) {
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            sink += focus_measure(sharp, step);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+        std::cout << ", step=" << step << " " << ms << " ms (" << ms / target_ms * 100 << "% of " << target_ms << " ms)";
+    }
+    std::cout << std::endl;
+#if defined(__AVX2__)
+    std::cout << "SIMD: AVX2";
+#elif defined(__SSE2__)
+    std::cout << "SIMD: SSE2";
+#else
+    std::cout << "SIMD: none";
+#endif
+    // 输出累加值，避免循环被优化掉
+    std::cout << " (" << (sink != 0) << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include<opencv2/opencv.hpp>
+#include<chrono>
+#include<iostream>
+#include<string>
+#include<vector>
+
+#include "hpp/image_view.hpp"
+
+// 对比 processImages 原先的 clone 后再转换与零拷贝视图直接转换，每帧复制的字节数及耗时
+struct stream_case {
+    std::string name;
+    ob2_image_format_t format;
+    int width;
+    int height;
+    int elem_size;  // 每像素字节数
+    int code;       // cvtColor 转换码，-1 表示按深度图缩放
+};
+
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{frames    |300|每种格式测试的帧数}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    int frames = parser.get<int>("frames");
+    std::vector<stream_case> cases = {
+        {"color YUYV 1920x1080", OB2_FORMAT_YUYV, 1920, 1080, 2, cv::COLOR_YUV2BGR_YUYV},
+        {"color RGB 1920x1080", OB2_FORMAT_RGB, 1920, 1080, 3, cv::COLOR_RGB2BGR},
+        {"depth Y16 640x480", OB2_FORMAT_Y16, 640, 480, 2, -1},
+        {"ir Y8 640x480", OB2_FORMAT_Y8, 640, 480, 1, cv::COLOR_GRAY2BGR},
+    };
+    for (auto &c : cases) {
+        int type = c.format == OB2_FORMAT_YUYV ? CV_8UC2 : c.format == OB2_FORMAT_RGB ? CV_8UC3 : c.format == OB2_FORMAT_Y16 ? CV_16UC1 : CV_8UC1;
+        uint32_t stride = c.width * c.elem_size;
+        std::vector<uint8_t> buffer(stride * c.height);
+        cv::randu(cv::Mat(1, (int)buffer.size(), CV_8UC1, buffer.data()), 0, 256);
+        cv::Mat out;
+
+        size_t copied = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            cv::Mat src = cv::Mat(c.height, c.width, type, buffer.data()).clone();
+            copied += src.total() * src.elemSize();
+            if (c.code < 0) {
+                out = src * 255 / 6000;
+            }
+            else {
+                cv::cvtColor(src, out, c.code);
+            }
+        }
+        double before_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+        size_t before_bytes = copied / frames;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            cv::Mat src = wrap_image_buffer(buffer.data(), (uint32_t)buffer.size(), c.format, c.width, c.height, stride);
+            if (c.code < 0) {
+                out = src * 255 / 6000;
+            }
+            else {
+                cv::cvtColor(src, out, c.code);
+            }
+        }
+        double after_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        std::cout << c.name << ": clone " << before_bytes << " bytes copied, " << before_ms << " ms/frame; view 0 bytes copied, " << after_ms << " ms/frame" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include<opencv2/opencv.hpp>
+#include<algorithm>
+#include<iostream>
+#include<vector>
+
+#include "hpp/corner_detect.hpp"
+
+// 对比单次全分辨率检测与由粗到精检测的各阶段耗时和精度
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{dir       |../imgs/|图像目录，图像按 0.jpg, 1.jpg ... 命名}"
+        "{cols      |11|棋盘格列数}"
+        "{rows      |8|棋盘格行数}"
+        "{side      |0.025|格子边长，单位：m}"
+        "{pyramid   |640|粗检测层的最大宽度}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    std::vector<std::string> paths = list_images(parser.get<std::string>("dir"));
+    if (paths.empty()) {
+        std::cout << "No image found in " << parser.get<std::string>("dir") << std::endl;
+        return -1;
+    }
+    detect_options single;
+    single.board_size = cv::Size(parser.get<int>("cols"), parser.get<int>("rows"));
+    detect_options pyramid = single;
+    pyramid.pyramid_width = parser.get<int>("pyramid");
+    float side = parser.get<float>("side");
+
+    double single_ms = 0, single_reject_ms = 0, coarse_ms = 0, refine_ms = 0, reject_ms = 0;
+    int single_found = 0, single_reject = 0, pyramid_found = 0, pyramid_reject = 0, both = 0;
+    double delta_sum = 0, delta_max = 0;
+    int delta_count = 0;
+    std::vector<std::vector<cv::Point2f> > single_points, pyramid_points;
+    std::vector<std::vector<cv::Point3f> > obj_points;
+    std::vector<cv::Point3f> obj_pt;
+    for (int i = 0; i < single.board_size.height; ++i) {
+        for (int j = 0; j < single.board_size.width; ++j) {
+            obj_pt.push_back(cv::Point3f(i * side, j * side, 0));
+        }
+    }
+    cv::Size im_size;
+    for (auto &path : paths) {
+        // 解码不计入检测耗时
+        cv::Mat gray = cv::imread(path, cv::IMREAD_GRAYSCALE);
+        im_size = gray.size();
+        auto start = std::chrono::steady_clock::now();
+        board_detection a = detect_board(gray, single);
+        double ms = elapsed_ms(start);
+        board_detection b = detect_board(gray, pyramid);
+        if (a.found) {
+            single_ms += ms;
+            ++single_found;
+        }
+        else {
+            single_reject_ms += ms;
+            ++single_reject;
+        }
+        if (b.found) {
+            coarse_ms += b.coarse_ms;
+            refine_ms += b.refine_ms;
+            ++pyramid_found;
+        }
+        else {
+            reject_ms += b.coarse_ms;
+            ++pyramid_reject;
+        }
+        if (a.found && b.found) {
+            ++both;
+            for (size_t k = 0; k < a.corners.size(); ++k) {
+                double d = cv::norm(a.corners[k] - b.corners[k]);
+                delta_sum += d;
+                delta_max = std::max(delta_max, d);
+                ++delta_count;
+            }
+            single_points.push_back(a.corners);
+            pyramid_points.push_back(b.corners);
+            obj_points.push_back(obj_pt);
+        }
+    }
+
+    std::cout << "single-pass: found " << single_found << ", " << single_ms / std::max(single_found, 1) << " ms/board; rejected "
+              << single_reject << ", " << single_reject_ms / std::max(single_reject, 1) << " ms/frame" << std::endl;
+    std::cout << "pyramid:     found " << pyramid_found << ", coarse " << coarse_ms / std::max(pyramid_found, 1) << " ms + refine "
+              << refine_ms / std::max(pyramid_found, 1) << " ms per board; rejected " << pyramid_reject << ", "
+              << reject_ms / std::max(pyramid_reject, 1) << " ms/frame" << std::endl;
+    if (delta_count == 0) {
+        return 0;
+    }
+    std::cout << "corner delta over " << both << " boards: mean " << delta_sum / delta_count << " px, max " << delta_max << " px" << std::endl;
+    if (both < 3) {
+        return 0;
+    }
+    // 用两组角点分别标定，比较内参
+    cv::Mat cam_a, dist_a, cam_b, dist_b;
+    std::vector<cv::Mat> rvecs, tvecs;
+    double rms_a = cv::calibrateCamera(obj_points, single_points, im_size, cam_a, dist_a, rvecs, tvecs);
+    double rms_b = cv::calibrateCamera(obj_points, pyramid_points, im_size, cam_b, dist_b, rvecs, tvecs);
+    std::cout << "fx/fy/cx/cy delta: " << cam_b.at<double>(0, 0) - cam_a.at<double>(0, 0) << " " << cam_b.at<double>(1, 1) - cam_a.at<double>(1, 1)
+              << " " << cam_b.at<double>(0, 2) - cam_a.at<double>(0, 2) << " " << cam_b.at<double>(1, 2) - cam_a.at<double>(1, 2) << std::endl;
+    std::cout << "RMS re-projection error: single-pass " << rms_a << ", pyramid " << rms_b << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include<opencv2/opencv.hpp>
+#include<cmath>
+#include<iostream>
+#include<sstream>
+#include<vector>
+
+#include "hpp/board_model.hpp"
+#include "hpp/incremental_calib.hpp"
+#include "hpp/schur_calib.hpp"
+
+// 生成 n 个随机位姿下的合成棋盘格视图，角点加入标准差为 noise 像素的高斯噪声
+static void synthesize(int n, cv::Size board_size, float side, const cv::Mat &K, const cv::Mat &dist, cv::Size im_size, double noise, cv::RNG &rng,
+                       object_views &obj_points, std::vector<std::vector<cv::Point2f> > &im_points) {
+    // 所有视图共用同一份物方点
+    cv::Mat obj_pt(chessboard_points(board_size, side), true);
+    cv::Point3f center(side * (board_size.height - 1) / 2, side * (board_size.width - 1) / 2, 0);
+    while ((int)im_points.size() < n) {
+        // 棋盘格中心位于相机前 0.4~1.0 m，绕各轴倾斜不超过约 35°
+        cv::Vec3d rvec(rng.uniform(-0.6, 0.6), rng.uniform(-0.6, 0.6), rng.uniform(-3.14, 3.14));
+        cv::Matx33d R;
+        cv::Rodrigues(rvec, R);
+        cv::Vec3d c = R * cv::Vec3d(center.x, center.y, center.z);
+        cv::Vec3d tvec(rng.uniform(-0.15, 0.15) - c[0], rng.uniform(-0.1, 0.1) - c[1], rng.uniform(0.4, 1.0) - c[2]);
+        std::vector<cv::Point2f> im_pt;
+        cv::projectPoints(obj_pt, rvec, tvec, K, dist, im_pt);
+        bool inside = true;
+        for (auto &p : im_pt) {
+            p.x += (float)rng.gaussian(noise);
+            p.y += (float)rng.gaussian(noise);
+            inside = inside && p.x >= 0 && p.y >= 0 && p.x < im_size.width && p.y < im_size.height;
+        }
+        if (inside) {
+            obj_points.push_back(obj_pt);
+            im_points.push_back(im_pt);
+        }
+    }
+}
+
+// 对比 calibrateCamera 与 Schur 补求解器在不同视图数下的耗时和精度
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{views     |50,500,5000|逗号分隔的视图数}"
+        "{max_opencv |500|视图数超过该值时跳过 calibrateCamera，其稠密法方程的内存随视图数平方增长}"
+        "{noise     |0.1|角点噪声标准差，单位：像素}"
+        "{threads j |0|Schur 求解器计算雅可比的线程数，0 表示使用全部核心}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    std::vector<int> view_counts;
+    std::stringstream views(parser.get<std::string>("views"));
+    for (std::string item; std::getline(views, item, ',');) {
+        view_counts.push_back(std::stoi(item));
+    }
+    int max_opencv = parser.get<int>("max_opencv");
+    double noise = parser.get<double>("noise");
+    int threads = parser.get<int>("threads");
+
+    cv::Size im_size(1920, 1080), board_size(11, 8);
+    cv::Mat K = (cv::Mat_<double>(3, 3) << 1380, 0, 962, 0, 1378, 545, 0, 0, 1);
+    cv::Mat dist = (cv::Mat_<double>(1, 5) << 0.12, -0.25, 0.0005, -0.0003, 0.1);
+    cv::TermCriteria criteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 50, 1e-12);
+
+    for (int n : view_counts) {
+        cv::RNG rng(n);
+        object_views obj_points;
+        std::vector<std::vector<cv::Point2f> > im_points;
+        synthesize(n, board_size, 0.025f, K, dist, im_size, noise, rng, obj_points, im_points);
+
+        auto report = [&](const char *name, const calib_result &r) {
+            double f_err = std::max(std::abs(r.cam_mat.at<double>(0, 0) - K.at<double>(0, 0)), std::abs(r.cam_mat.at<double>(1, 1) - K.at<double>(1, 1)));
+            double c_err = std::max(std::abs(r.cam_mat.at<double>(0, 2) - K.at<double>(0, 2)), std::abs(r.cam_mat.at<double>(1, 2) - K.at<double>(1, 2)));
+            std::cout << "views = " << n << "\t" << name << "\t" << r.solve_ms << " ms\trms = " << r.rms << "\t|f err| = " << f_err << " px\t|c err| = " << c_err
+                      << " px\tsigma fx = " << r.cam_deviation.at<double>(0) << std::endl;
+        };
+        if (n <= max_opencv) {
+            report("opencv", calibrate_views(obj_points, im_points, im_size, nullptr, criteria));
+        }
+        else {
+            std::cout << "views = " << n << "\topencv\tskipped" << std::endl;
+        }
+        report("schur ", calibrate_views_schur(obj_points, im_points, im_size, nullptr, criteria, threads));
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include<opencv2/opencv.hpp>
+#include<algorithm>
+#include<cfloat>
+#include<chrono>
+#include<cmath>
+#include<iostream>
+#include<sstream>
+#include<vector>
+
+#include "hpp/schur_calib.hpp"
+#include "hpp/synthetic_board.hpp"
+
+// 在按真值内参渲染的棋盘格图像上测试整个标定流程：渲染、角点检测的吞吐量和角点误差，
+// 以及 calibrateCamera 与 Schur 补求解器的耗时和内参、畸变系数相对真值的误差。不需要相机和实拍图像
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{views     |40|渲染的视图数}"
+        "{cols      |11|棋盘格列数}"
+        "{rows      |8|棋盘格行数}"
+        "{side      |0.025|格子边长，单位：m}"
+        "{width     |1920|图像宽度}"
+        "{height    |1080|图像高度}"
+        "{noise     |2|灰度噪声的标准差}"
+        "{blur      |0.8|高斯模糊的标准差，单位：像素}"
+        "{near      |0.4|标定板到相机的最近距离，单位：m}"
+        "{far       |1.0|标定板到相机的最远距离，单位：m}"
+        "{tilt      |0.6|标定板倾斜的上限，单位：rad}"
+        "{supersample |2|渲染时每个像素在两个方向上的采样数}"
+        "{seed      |1|随机数种子，相同的种子生成相同的视图}"
+        "{pyramid   |0|大于 0 时启用由粗到精检测，值为粗检测层的最大宽度}"
+        "{threads j |0|渲染、检测和 Schur 求解器的线程数，0 表示使用全部核心}"
+        "{out       ||非空时把视图按 grasp 的命名保存到该目录（须事先创建），真值写入其中的 ground_truth.yml}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    int n = parser.get<int>("views");
+    int threads = parser.get<int>("threads");
+    std::string out_dir = parser.get<std::string>("out");
+
+    // 真值内参按 1920x1080 下的典型彩色相机设置，随分辨率等比例缩放
+    synthetic_options syn;
+    syn.board_size = cv::Size(parser.get<int>("cols"), parser.get<int>("rows"));
+    syn.side = parser.get<float>("side");
+    syn.im_size = cv::Size(parser.get<int>("width"), parser.get<int>("height"));
+    double sx = syn.im_size.width / 1920.0, sy = syn.im_size.height / 1080.0;
+    syn.K = (cv::Mat_<double>(3, 3) << 1380 * sx, 0, 962 * sx, 0, 1378 * sy, 545 * sy, 0, 0, 1);
+    syn.dist = (cv::Mat_<double>(1, 5) << 0.12, -0.25, 0.0005, -0.0003, 0.1);
+    syn.noise = parser.get<double>("noise");
+    syn.blur = parser.get<double>("blur");
+    syn.min_distance = parser.get<double>("near");
+    syn.max_distance = parser.get<double>("far");
+    syn.max_tilt = parser.get<double>("tilt");
+    syn.supersample = parser.get<int>("supersample");
+    syn.threads = threads;
+
+    auto start = std::chrono::steady_clock::now();
+    synthetic_renderer renderer(syn);
+    double setup_ms = elapsed_ms(start);
+    cv::RNG rng(parser.get<int>("seed"));
+    std::vector<synthetic_view> views;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        views.push_back(renderer.render(rng));
+    }
+    double render_ms = elapsed_ms(start);
+    std::cout << n << " views " << syn.im_size.width << "x" << syn.im_size.height << ", board " << syn.board_size.width << "x" << syn.board_size.height
+              << ": setup " << setup_ms << " ms, render " << render_ms / n << " ms per view" << std::endl;
+
+    if (!out_dir.empty()) {
+        for (int i = 0; i < n; ++i) {
+            std::stringstream buffer;
+            buffer << out_dir << i << ".jpg";
+            cv::imwrite(buffer.str(), views[i].image);
+        }
+        // 与 calibrate 输出的内参文件格式相同，可直接与标定结果对比
+        cv::FileStorage fs(out_dir + "ground_truth.yml", cv::FileStorage::WRITE);
+        fs << "width" << syn.im_size.width << "height" << syn.im_size.height << "camera_matrix" << syn.K << "dist_coeffs" << syn.dist;
+        fs << "views" << "[";
+        for (auto &v : views) {
+            fs << "{" << "rvec" << cv::Mat(v.rvec) << "tvec" << cv::Mat(v.tvec) << "}";
+        }
+        fs << "]";
+        std::cout << "Saved views and ground truth to " << out_dir << std::endl;
+    }
+
+    // 图像级并行检测，与 calibrate 相同
+    detect_options opt;
+    opt.board_size = syn.board_size;
+    opt.pyramid_width = parser.get<int>("pyramid");
+    std::vector<board_detection> detections(n);
+    int cv_threads = cv::getNumThreads();
+    cv::setNumThreads(1);
+    start = std::chrono::steady_clock::now();
+    parallel_for_index(n, threads, [&](int i) { detections[i] = detect_board(views[i].image, opt); });
+    double detect_sec = elapsed_ms(start) / 1000;
+    cv::setNumThreads(cv_threads);
+
+    // 检测到的角点顺序与真值可能相差行、列方向的翻转，取四种对应方式中误差最小的一种
+    object_views obj_points;
+    std::vector<std::vector<cv::Point2f> > im_points;
+    cv::Mat obj_pt(chessboard_points(syn.board_size, syn.side), true);
+    const int w = syn.board_size.width, h = syn.board_size.height;
+    auto truth_index = [&](int k, int flip) {
+        int r = k / w, c = k % w;
+        return ((flip & 1) ? h - 1 - r : r) * w + ((flip & 2) ? w - 1 - c : c);
+    };
+    double sq_err = 0, max_err = 0;
+    for (int i = 0; i < n; ++i) {
+        const board_detection &det = detections[i];
+        if (!det.found) {
+            continue;
+        }
+        const std::vector<cv::Point2f> &truth = views[i].corners;
+        double best = DBL_MAX;
+        int best_flip = 0;
+        for (int flip = 0; flip < 4; ++flip) {
+            double err = 0;
+            for (int k = 0; k < w * h; ++k) {
+                cv::Point2f d = det.corners[k] - truth[truth_index(k, flip)];
+                err += d.dot(d);
+            }
+            if (err < best) {
+                best = err;
+                best_flip = flip;
+            }
+        }
+        for (int k = 0; k < w * h; ++k) {
+            cv::Point2f d = det.corners[k] - truth[truth_index(k, best_flip)];
+            max_err = std::max(max_err, (double)std::sqrt(d.dot(d)));
+        }
+        sq_err += best;
+        obj_points.push_back(obj_pt);
+        im_points.push_back(det.corners);
+    }
+    int found = (int)im_points.size();
+    std::cout << "Detection: " << found << "/" << n << " found, " << n / detect_sec << " images/sec, corner error rms "
+              << (found ? std::sqrt(sq_err / (found * obj_pt.rows)) : 0) << " px, max " << max_err << " px" << std::endl;
+    if (found < 3) {
+        std::cout << "Too few views to calibrate" << std::endl;
+        return -1;
+    }
+
+    const cv::TermCriteria criteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 50, 1e-12);
+    const char *dist_names[] = {"k1", "k2", "p1", "p2", "k3"};
+    auto report = [&](const char *name, const calib_result &r) {
+        std::cout << name << "\t" << r.solve_ms << " ms\trms = " << r.rms << " px\terror fx " << r.cam_mat.at<double>(0, 0) - syn.K.at<double>(0, 0) << " fy "
+                  << r.cam_mat.at<double>(1, 1) - syn.K.at<double>(1, 1) << " cx " << r.cam_mat.at<double>(0, 2) - syn.K.at<double>(0, 2) << " cy "
+                  << r.cam_mat.at<double>(1, 2) - syn.K.at<double>(1, 2) << " px";
+        for (int k = 0; k < 5; ++k) {
+            std::cout << " " << dist_names[k] << " " << r.dist.at<double>(k) - syn.dist.at<double>(k);
+        }
+        std::cout << std::endl;
+    };
+    report("opencv", calibrate_views(obj_points, im_points, syn.im_size, nullptr, criteria));
+    report("schur ", calibrate_views_schur(obj_points, im_points, syn.im_size, nullptr, criteria, threads));
+    return 0;
+}
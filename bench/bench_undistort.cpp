@@ -0,0 +1,77 @@
+#include<opencv2/opencv.hpp>
+#include<chrono>
+#include<cstdio>
+#include<iostream>
+#include<string>
+
+#include "hpp/undistort_map.hpp"
+
+// 去畸变的耗时：浮点映射表与定点映射表的构建、缓存文件的读取，以及单线程、多线程 remap 的单帧耗时及占 30 fps 帧间隔的比例
+int main(int argc, char **argv)
+{
+    cv::CommandLineParser parser(argc, argv,
+        "{help h    ||打印帮助}"
+        "{frames    |200|remap 测试的帧数}"
+        "{width     |1920|图像宽度}"
+        "{height    |1080|图像高度}"
+        "{cache     |bench_undistort.map|测试用的映射表缓存文件，结束后删除}");
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 0;
+    }
+    int frames = parser.get<int>("frames");
+    cv::Size size(parser.get<int>("width"), parser.get<int>("height"));
+    std::string cache_path = parser.get<std::string>("cache");
+    const double budget_ms = 1000.0 / 30;
+
+    // 典型的彩色相机内参与桶形畸变
+    double f = size.width * 0.75;
+    cv::Mat K = (cv::Mat_<double>(3, 3) << f, 0, size.width / 2.0, 0, f, size.height / 2.0, 0, 0, 1);
+    cv::Mat dist = (cv::Mat_<double>(1, 5) << -0.12, 0.08, 0.0005, -0.0003, -0.02);
+    cv::Mat src(size, CV_8UC3);
+    cv::randu(src, 0, 256);
+
+    auto start = std::chrono::steady_clock::now();
+    cv::Mat new_K = cv::getOptimalNewCameraMatrix(K, dist, size, 0, size);
+    cv::Mat fx, fy;
+    cv::initUndistortRectifyMap(K, dist, cv::Mat(), new_K, size, CV_32FC1, fx, fy);
+    double float_build_ms = elapsed_ms(start);
+
+    std::remove(cache_path.c_str());
+    undistort_map map;
+    map.prepare(K, dist, size, size, 0, cache_path);
+    double fixed_build_ms = map.build_ms();
+    undistort_map cached;
+    start = std::chrono::steady_clock::now();
+    cached.prepare(K, dist, size, size, 0, cache_path);
+    double load_ms = elapsed_ms(start);
+    std::cout << size.width << "x" << size.height << " map: float build " << float_build_ms << " ms (" << size.area() * 8 << " bytes), fixed-point build "
+              << fixed_build_ms << " ms (" << size.area() * 6 << " bytes), cache " << (cached.from_cache() ? "load " : "miss ") << load_ms << " ms" << std::endl;
+
+    cv::Mat ref, out;
+    int cv_threads = cv::getNumThreads();
+    for (int threads : {1, cv_threads}) {
+        cv::setNumThreads(threads);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            cv::remap(src, ref, fx, fy, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        }
+        double float_ms = elapsed_ms(start) / frames;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            cached.apply(src, out);
+        }
+        double fixed_ms = elapsed_ms(start) / frames;
+        std::cout << threads << " thread(s): float remap " << float_ms << " ms (" << float_ms / budget_ms * 100 << "% of 30 fps), fixed-point remap "
+                  << fixed_ms << " ms (" << fixed_ms / budget_ms * 100 << "% of 30 fps)" << std::endl;
+    }
+    cv::setNumThreads(cv_threads);
+
+    // 定点映射表的插值系数量化为 1/32 像素，与浮点映射表的结果相差很小
+    cv::Mat diff;
+    cv::absdiff(ref, out, diff);
+    cv::Scalar mean = cv::mean(diff);
+    std::cout << "max channel diff " << cv::norm(diff, cv::NORM_INF) << ", mean " << (mean[0] + mean[1] + mean[2]) / 3 << std::endl;
+    std::remove(cache_path.c_str());
+    return 0;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "hpp/OB2Camera.hpp"
+#include "hpp/spsc_ring.hpp"
+
+// 某一处理阶段的耗时统计
+struct stage_stats {
+    int count = 0;
+    double total_ms = 0;
+    double max_ms = 0;
+
+    void add(double ms) {
+        ++count;
+        total_ms += ms;
+        max_ms = std::max(max_ms, ms);
+    }
+
+    void print(const std::string &name) const {
+        std::cout << name << ": " << count << " frames, avg " << (count ? total_ms / count : 0) << " ms, max " << max_ms << " ms" << std::endl;
+    }
+};
+
+// 从环形队列中取出的一帧，arrival 为采集线程收到该帧的时刻
+struct stamped_capture {
+    std::shared_ptr<ob2::capture> capture;
+    std::chrono::steady_clock::time_point arrival;
+    int index = -1;
+};
+
+// 采集与显示解耦：SDK 的回调线程（相机或回放）作为唯一生产者把 capture 推入无锁环形队列，
+// 显示、保存在消费线程中处理，渲染卡顿不会阻塞采集，只会在队列满时丢帧并计数
+class acquisition {
+public:
+    explicit acquisition(size_t capacity) : _ring(capacity), _received(0), _dropped(0), _skipped(0), _closed(false) {}
+
+    acquisition(const acquisition &) = delete;
+    acquisition &operator=(const acquisition &) = delete;
+
+    // 只能在生产者线程中调用。block 为 false 时队列满则丢弃该帧并返回 false
+    bool submit(std::shared_ptr<ob2::capture> capture, bool block) {
+        stamped_capture c;
+        c.capture = std::move(capture);
+        c.arrival = std::chrono::steady_clock::now();
+        c.index = _received++;
+        while (!_ring.try_push(c)) {
+            if (!block || _closed.load(std::memory_order_acquire)) {
+                ++_dropped;
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // 只能在消费者线程中调用。取出下一帧，队列为空时返回 false
+    bool next(stamped_capture &out) {
+        return _ring.try_pop(out);
+    }
+
+    // 只能在消费者线程中调用。取出最新的一帧，积压的旧帧被跳过并计入 skipped
+    bool latest(stamped_capture &out) {
+        if (!_ring.try_pop(out)) {
+            return false;
+        }
+        stamped_capture newer;
+        while (_ring.try_pop(newer)) {
+            out = std::move(newer);
+            ++_skipped;
+        }
+        return true;
+    }
+
+    // 生产者不再提交新帧，例如回放结束
+    void close() {
+        _closed.store(true, std::memory_order_release);
+    }
+
+    bool closed() const {
+        return _closed.load(std::memory_order_acquire);
+    }
+
+    // 采集线程收到的帧数
+    int received() const {
+        return _received;
+    }
+
+    // 队列满而被采集线程丢弃的帧数
+    int dropped() const {
+        return _dropped;
+    }
+
+    // 显示来不及处理而被跳过的帧数
+    int skipped() const {
+        return _skipped;
+    }
+
+private:
+    spsc_ring<stamped_capture> _ring;
+    std::atomic<int> _received;
+    std::atomic<int> _dropped;
+    std::atomic<int> _skipped;
+    std::atomic<bool> _closed;
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "hpp/bounded_queue.hpp"
+#include "hpp/corner_detect.hpp"
+#include "hpp/focus_measure.hpp"
+
+struct auto_capture_options {
+    cv::Size board_size;
+    int detect_width = 640;          // 快速检测所用缩小图像的最大宽度
+    double max_motion = 1.5;         // 相邻两次检测间角点的平均位移上限，单位：原图像素
+    int stable_frames = 3;           // 连续静止的检测次数达到该值才评估清晰度
+    double min_sharpness = 100;      // 标定板区域拉普拉斯响应的方差下限，逐像素计算
+    double min_focus = 0;            // 大于 0 时先按 focus_step 计算整幅图像的清晰度，低于该值的帧不做棋盘格检测
+    int focus_step = 2;
+    double min_novelty = 0.05;       // 与已保存视图的最小位姿差异，外侧四角点坐标按图像宽高归一化后的均方根距离
+    cv::Size grid = cv::Size(8, 6);  // 统计角点覆盖的网格
+    int min_new_cells = 2;           // 位姿相近但新覆盖的网格数达到该值时仍然保存
+};
+
+// 自动采集：后台线程对实时图像做快速棋盘格检测，只在标定板静止、清晰且带来新位姿或新覆盖区域时
+// 调用 on_accept 保存该帧，代替手动按's'。提交不会阻塞，线程忙时新帧被丢弃
+class auto_capture {
+public:
+    auto_capture(const auto_capture_options &opt, std::function<void(const cv::Mat &bgr, const cv::Mat &gray, uint64_t timestamp_usec)> on_accept)
+        : _opt(opt), _on_accept(on_accept), _queue(1), _covered(opt.grid.area(), 0), _stable(0), _examined(0), _no_board(0), _moving(0), _blurry(0),
+          _redundant(0), _accepted(0), _total_ms(0), _focus_ms(0), _focus_count(0), _stopped(false) {
+        _worker = std::thread(&auto_capture::run, this);
+    }
+
+    ~auto_capture() {
+        stop();
+    }
+
+    auto_capture(const auto_capture &) = delete;
+    auto_capture &operator=(const auto_capture &) = delete;
+
+    // bgr 在处理完之前不能被修改
+    bool submit(const cv::Mat &bgr, uint64_t timestamp_usec) {
+        return _queue.try_push({bgr, timestamp_usec});
+    }
+
+    // 处理完已提交的帧后停止后台线程
+    void stop() {
+        if (!_stopped) {
+            _stopped = true;
+            _queue.close();
+            _worker.join();
+        }
+    }
+
+    int accepted() const {
+        return _accepted;
+    }
+
+    void print(std::ostream &out) const {
+        out << "Auto capture: " << _examined << " frames examined, " << _no_board << " without board, " << _moving << " moving, " << _blurry << " blurry, "
+            << _redundant << " redundant, " << _accepted << " saved, avg " << (_examined ? _total_ms / _examined : 0) << " ms per frame, focus "
+            << (_focus_count ? _focus_ms / _focus_count : 0) << " ms" << std::endl;
+    }
+
+private:
+    struct frame {
+        cv::Mat bgr;
+        uint64_t timestamp_usec;
+    };
+
+    auto_capture_options _opt;
+    std::function<void(const cv::Mat &, const cv::Mat &, uint64_t)> _on_accept;
+    bounded_queue<frame> _queue;
+    std::vector<cv::Point2f> _prev;
+    std::vector<std::vector<cv::Point2f> > _saved;  // 已保存视图外侧四角点的归一化坐标
+    std::vector<char> _covered;
+    int _stable;
+    std::atomic<int> _examined, _no_board, _moving, _blurry, _redundant, _accepted;
+    double _total_ms;
+    double _focus_ms;  // 清晰度评分的总耗时
+    int _focus_count;
+    bool _stopped;
+    std::thread _worker;
+
+    void run() {
+        frame f;
+        while (_queue.pop(f)) {
+            auto start = std::chrono::steady_clock::now();
+            process(f.bgr, f.timestamp_usec);
+            _total_ms += elapsed_ms(start);
+            ++_examined;
+        }
+    }
+
+    double focus(const cv::Mat &gray, int step) {
+        auto start = std::chrono::steady_clock::now();
+        double score = focus_measure(gray, step);
+        _focus_ms += elapsed_ms(start);
+        ++_focus_count;
+        return score;
+    }
+
+    void process(const cv::Mat &bgr, uint64_t timestamp_usec) {
+        cv::Mat gray;
+        cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+        // 明显模糊的帧在棋盘格检测之前就排除
+        if (_opt.min_focus > 0 && focus(gray, _opt.focus_step) < _opt.min_focus) {
+            ++_blurry;
+            _stable = 0;
+            _prev.clear();
+            return;
+        }
+        cv::Mat small = gray;
+        float scale = 1;
+        if (gray.cols > _opt.detect_width) {
+            scale = (float)gray.cols / _opt.detect_width;
+            cv::resize(gray, small, cv::Size(), 1 / scale, 1 / scale, cv::INTER_AREA);
+        }
+        // 只需判断有无标定板及其大致位置，用带快速排除的 findChessboardCorners，不做亚像素精化
+        std::vector<cv::Point2f> corners;
+        if (!cv::findChessboardCorners(small, _opt.board_size, corners, cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_FAST_CHECK)) {
+            ++_no_board;
+            _stable = 0;
+            _prev.clear();
+            return;
+        }
+        for (auto &p : corners) {
+            p *= scale;
+        }
+        double motion = DBL_MAX;
+        if (_prev.size() == corners.size()) {
+            // 角点顺序可能整体反转，取两种对应方式中较小的位移
+            double forward = 0, backward = 0;
+            for (size_t i = 0; i < corners.size(); ++i) {
+                forward += cv::norm(corners[i] - _prev[i]);
+                backward += cv::norm(corners[i] - _prev[_prev.size() - 1 - i]);
+            }
+            motion = std::min(forward, backward) / corners.size();
+        }
+        _prev = corners;
+        if (motion > _opt.max_motion || ++_stable < _opt.stable_frames) {
+            if (motion > _opt.max_motion) {
+                _stable = 0;
+            }
+            ++_moving;
+            return;
+        }
+        // 逐像素的评分与 4 邻域的 cv::Laplacian 相同
+        cv::Rect roi = cv::boundingRect(corners) & cv::Rect(0, 0, gray.cols, gray.rows);
+        if (focus(gray(roi), 1) < _opt.min_sharpness) {
+            ++_blurry;
+            return;
+        }
+
+        const int w = _opt.board_size.width, h = _opt.board_size.height;
+        std::vector<cv::Point2f> outer = {corners[0], corners[w - 1], corners[(h - 1) * w], corners[h * w - 1]};
+        for (auto &p : outer) {
+            p = cv::Point2f(p.x / gray.cols, p.y / gray.rows);
+        }
+        double novelty = DBL_MAX;
+        for (auto &s : _saved) {
+            double forward = 0, backward = 0;
+            for (int k = 0; k < 4; ++k) {
+                cv::Point2f d = outer[k] - s[k], e = outer[k] - s[3 - k];
+                forward += d.dot(d);
+                backward += e.dot(e);
+            }
+            novelty = std::min(novelty, std::sqrt(std::min(forward, backward) / 4));
+        }
+        std::vector<int> cells;
+        for (auto &p : corners) {
+            int cx = std::min(_opt.grid.width - 1, std::max(0, (int)(p.x * _opt.grid.width / gray.cols)));
+            int cy = std::min(_opt.grid.height - 1, std::max(0, (int)(p.y * _opt.grid.height / gray.rows)));
+            int cell = cy * _opt.grid.width + cx;
+            if (!_covered[cell] && std::find(cells.begin(), cells.end(), cell) == cells.end()) {
+                cells.push_back(cell);
+            }
+        }
+        if (novelty < _opt.min_novelty && (int)cells.size() < _opt.min_new_cells) {
+            ++_redundant;
+            return;
+        }
+
+        _saved.push_back(outer);
+        for (int cell : cells) {
+            _covered[cell] = 1;
+        }
+        _stable = 0;
+        ++_accepted;
+        _on_accept(bgr, gray, timestamp_usec);
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 对一行字节做 (a * w0 + b * w1 + 128) >> 8，w0 + w1 = 256
+inline void blend_row(const uchar *a, const uchar *b, uchar *dst, int n, int w0, int w1) {
+    int x = 0;
+#if defined(__AVX2__)
+    __m256i zero = _mm256_setzero_si256();
+    __m256i vw0 = _mm256_set1_epi16((short)w0);
+    __m256i vw1 = _mm256_set1_epi16((short)w1);
+    __m256i half = _mm256_set1_epi16(128);
+    for (; x + 32 <= n; x += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + x));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + x));
+        // unpack 与 packus 都在 128 位通道内进行，先拆后合顺序不变
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(va, zero), vw0), _mm256_mullo_epi16(_mm256_unpacklo_epi8(vb, zero), vw1));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(va, zero), vw0), _mm256_mullo_epi16(_mm256_unpackhi_epi8(vb, zero), vw1));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, half), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, half), 8);
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_packus_epi16(lo, hi));
+    }
+#elif defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    __m128i vw0 = _mm_set1_epi16((short)w0);
+    __m128i vw1 = _mm_set1_epi16((short)w1);
+    __m128i half = _mm_set1_epi16(128);
+    for (; x + 16 <= n; x += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + x));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + x));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), vw0), _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), vw1));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), vw0), _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), vw1));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, half), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, half), 8);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < n; ++x) {
+        dst[x] = (uchar)((a[x] * w0 + b[x] * w1 + 128) >> 8);
+    }
+}
+
+// dst = src0 * (1 - alpha) + src1 * alpha，按行并行，权重为 8 位定点数。
+// src0、src1 须同尺寸同类型（8 位，任意通道数）；dst 可以就是 src0 或 src1，即原地混合
+inline void blend(const cv::Mat &src0, const cv::Mat &src1, float alpha, cv::Mat &dst) {
+    CV_Assert(src0.size() == src1.size() && src0.type() == src1.type() && src0.depth() == CV_8U);
+    int w1 = (int)(std::min(std::max(alpha, 0.f), 1.f) * 256 + 0.5f);
+    int w0 = 256 - w1;
+    // dst 与输入共用数据时 create 不会重新分配
+    cv::Mat a = src0, b = src1;
+    dst.create(a.size(), a.type());
+    int n = a.cols * (int)a.elemSize();
+    cv::parallel_for_(cv::Range(0, a.rows), [&](const cv::Range &rows) {
+        for (int y = rows.start; y < rows.end; ++y) {
+            blend_row(a.ptr<uchar>(y), b.ptr<uchar>(y), dst.ptr<uchar>(y), n, w0, w1);
+        }
+    }, a.rows / 64.0);
+}
@@ -0,0 +1,298 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <opencv2/objdetect/charuco_detector.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hpp/corner_detect.hpp"
+
+// 各视图的物方点。完整检测的视图共用标定板模型中同一块预先计算的数据，只复制 Mat 头
+typedef std::vector<cv::Mat> object_views;
+
+// 棋盘格角点的物方坐标，顺序与 findChessboardCorners 返回的角点一致
+inline std::vector<cv::Point3f> chessboard_points(cv::Size board_size, float side_length) {
+    std::vector<cv::Point3f> obj_pt;
+    for (int i = 0; i < board_size.height; ++i) {
+        for (int j = 0; j < board_size.width; ++j) {
+            obj_pt.push_back(cv::Point3f(i * side_length, j * side_length, 0));
+        }
+    }
+    return obj_pt;
+}
+
+enum board_type {
+    BOARD_CHESSBOARD,          // 棋盘格，cols x rows 为内角点数
+    BOARD_CIRCLES,             // 对称圆点阵列，cols x rows 为圆点数
+    BOARD_ASYMMETRIC_CIRCLES,  // 非对称圆点阵列，cols x rows 为圆点数
+    BOARD_CHARUCO              // ChArUco，cols x rows 为格子数，内角点为 (cols - 1) x (rows - 1)
+};
+
+// 标定板模型：类型、尺寸、预先计算的物方点以及对应的检测方法。
+// 可由命令行参数或 YAML 文件构造，新增标定板不需要重新编译
+class board_model : public std::enable_shared_from_this<board_model> {
+public:
+    board_model(board_type type, cv::Size size, float square, float marker = 0, int dictionary = cv::aruco::DICT_5X5_100)
+        : _type(type), _size(size), _square(square), _marker(marker), _dictionary(dictionary) {
+        switch (_type) {
+        case BOARD_CHESSBOARD:
+            _points = chessboard_points(_size, _square);
+            break;
+        case BOARD_CIRCLES:
+            for (int i = 0; i < _size.height; ++i) {
+                for (int j = 0; j < _size.width; ++j) {
+                    _points.push_back(cv::Point3f(j * _square, i * _square, 0));
+                }
+            }
+            break;
+        case BOARD_ASYMMETRIC_CIRCLES:
+            for (int i = 0; i < _size.height; ++i) {
+                for (int j = 0; j < _size.width; ++j) {
+                    _points.push_back(cv::Point3f((2 * j + i % 2) * _square, i * _square, 0));
+                }
+            }
+            break;
+        case BOARD_CHARUCO:
+            _charuco = cv::makePtr<cv::aruco::CharucoBoard>(_size, _square, _marker, cv::aruco::getPredefinedDictionary(_dictionary));
+            _points = _charuco->getChessboardCorners();
+            break;
+        }
+        _points_mat = cv::Mat(_points);
+    }
+
+    board_model(const board_model &) = delete;
+    board_model &operator=(const board_model &) = delete;
+
+    // 读取标定板描述文件，格式见 README；读取失败时返回空指针
+    static std::shared_ptr<board_model> load(const std::string &path) {
+        cv::FileStorage fs(path, cv::FileStorage::READ);
+        if (!fs.isOpened()) {
+            std::cout << "Fail to open " << path << std::endl;
+            return nullptr;
+        }
+        board_type type;
+        if (!parse_type((std::string)fs["type"], type)) {
+            std::cout << "Unknown board type " << (std::string)fs["type"] << " in " << path << std::endl;
+            return nullptr;
+        }
+        int dictionary = cv::aruco::DICT_5X5_100;
+        if (!fs["dictionary"].empty() && !parse_dictionary((std::string)fs["dictionary"], dictionary)) {
+            std::cout << "Unknown dictionary " << (std::string)fs["dictionary"] << " in " << path << std::endl;
+            return nullptr;
+        }
+        return std::make_shared<board_model>(type, cv::Size((int)fs["cols"], (int)fs["rows"]), (float)fs["square"], (float)fs["marker"], dictionary);
+    }
+
+    static bool parse_type(const std::string &name, board_type &type) {
+        static const char *names[] = {"chessboard", "circles", "asymmetric_circles", "charuco"};
+        for (int t = 0; t < 4; ++t) {
+            if (name == names[t]) {
+                type = (board_type)t;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 预定义字典名，如 DICT_5X5_100
+    static bool parse_dictionary(const std::string &name, int &dictionary) {
+        static const int bits[] = {4, 5, 6, 7};
+        static const int counts[] = {50, 100, 250, 1000};
+        for (int b = 0; b < 4; ++b) {
+            for (int c = 0; c < 4; ++c) {
+                std::ostringstream buff;
+                buff << "DICT_" << bits[b] << "X" << bits[b] << "_" << counts[c];
+                if (name == buff.str()) {
+                    dictionary = cv::aruco::DICT_4X4_50 + b * 4 + c;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    board_type type() const {
+        return _type;
+    }
+
+    // 检测结果中完整标定板的角点（圆心）数
+    int point_count() const {
+        return (int)_points.size();
+    }
+
+    // findChessboardCorners、findCirclesGrid 使用的图案尺寸；ChArUco 为内角点的列数和行数
+    cv::Size pattern_size() const {
+        return _type == BOARD_CHARUCO ? cv::Size(_size.width - 1, _size.height - 1) : _size;
+    }
+
+    const std::vector<cv::Point3f> &object_points() const {
+        return _points;
+    }
+
+    // 一个视图的物方点：完整检测时返回共享数据的 Mat 头，部分检测时按角点编号取子集
+    cv::Mat view_points(const board_detection &det) const {
+        if (det.ids.empty()) {
+            return _points_mat;
+        }
+        cv::Mat subset((int)det.ids.size(), 1, CV_32FC3);
+        for (size_t k = 0; k < det.ids.size(); ++k) {
+            subset.at<cv::Point3f>((int)k) = _points[det.ids[k]];
+        }
+        return subset;
+    }
+
+    // 编号对应的物方点是否共线，共线的角点无法确定单应矩阵，不能用于标定
+    bool collinear(const std::vector<int> &ids) const {
+        if (ids.size() < 3) {
+            return true;
+        }
+        const cv::Point3f &a = _points[ids[0]];
+        size_t k = 1;
+        while (k < ids.size() && _points[ids[k]] == a) {
+            ++k;
+        }
+        if (k == ids.size()) {
+            return true;
+        }
+        cv::Point3f d = _points[ids[k]] - a;
+        for (; k < ids.size(); ++k) {
+            cv::Point3f e = _points[ids[k]] - a;
+            if (std::abs(d.x * e.y - d.y * e.x) > 1e-6f * _square * _square) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 标定板图案的平面内旋转对称，每个排列 perm 表示检测到的第 k 个角点可能对应物方点 perm[k]，第一个为恒等排列。
+    // 检测器在对称的图案上可能从不同的角开始排列，多台相机的角点顺序因此可能不一致；
+    // 行列数一奇一偶的棋盘格由格子颜色、ChArUco 由编号确定唯一的顺序，只有恒等排列
+    std::vector<std::vector<int> > symmetries() const {
+        const int n = point_count();
+        const cv::Size grid = pattern_size();
+        std::vector<std::vector<int> > perms(1, std::vector<int>(n));
+        for (int k = 0; k < n; ++k) {
+            perms[0][k] = k;
+        }
+        if (_type == BOARD_CHARUCO || grid.width < 2 || grid.height < 2) {
+            return perms;
+        }
+        const int w = grid.width, h = grid.height;
+        // 候选为旋转 180 度，正方形图案再加旋转 90、270 度
+        std::vector<std::vector<int> > candidates(1, std::vector<int>(n));
+        for (int k = 0; k < n; ++k) {
+            candidates[0][k] = n - 1 - k;
+        }
+        if (w == h) {
+            std::vector<int> r90(n), r270(n);
+            for (int r = 0; r < h; ++r) {
+                for (int c = 0; c < w; ++c) {
+                    r90[r * w + c] = c * w + (w - 1 - r);
+                    r270[r * w + c] = (h - 1 - c) * w + r;
+                }
+            }
+            candidates.push_back(r90);
+            candidates.push_back(r270);
+        }
+        // 物方点经过排列后须与原图案相差一个保持方向的刚体变换；棋盘格还须保持格子颜色
+        const cv::Point3f u = _points[1] - _points[0], v = _points[w] - _points[0];
+        const float cross = u.x * v.y - u.y * v.x, tol = 1e-4f * _square;
+        for (const std::vector<int> &perm : candidates) {
+            const cv::Point3f o = _points[perm[0]], u2 = _points[perm[1]] - o, v2 = _points[perm[w]] - o;
+            bool same = std::abs(cv::norm(u2) - cv::norm(u)) < tol && std::abs(cv::norm(v2) - cv::norm(v)) < tol && cross * (u2.x * v2.y - u2.y * v2.x) > 0;
+            for (int k = 0; same && k < n; ++k) {
+                int r = k / w, c = k % w;
+                cv::Point3f expected = o + (float)c * u2 + (float)r * v2;
+                same = cv::norm(_points[perm[k]] - expected) < tol;
+            }
+            if (same && _type == BOARD_CHESSBOARD) {
+                // 角点 0、w + 1 围成的格子映射后所在格子的行列号之和须为偶数
+                int a = perm[0], b = perm[w + 1];
+                same = (std::min(a / w, b / w) + std::min(a % w, b % w)) % 2 == 0;
+            }
+            if (same) {
+                perms.push_back(perm);
+            }
+        }
+        return perms;
+    }
+
+    // 标识模型的字符串，参与角点缓存的键
+    std::string key() const {
+        std::ostringstream buff;
+        buff << _type << ":" << _size.width << "x" << _size.height << ":" << _square << ":" << _marker << ":" << _dictionary;
+        return buff.str();
+    }
+
+    // 把按本模型检测所需的设置填入 opt。opt.detector 持有本模型的 shared_ptr，
+    // 复制到长期运行的流水线中也不会悬空，因此本模型须由 shared_ptr 管理（load 或 std::make_shared）
+    void configure(detect_options &opt) const {
+        opt.board_size = pattern_size();
+        if (_type == BOARD_CHESSBOARD) {
+            opt.detector = nullptr;
+            opt.board_key.clear();
+            return;
+        }
+        std::shared_ptr<const board_model> self = shared_from_this();
+        opt.detector = [self](const cv::Mat &gray, const detect_options &o) { return self->detect(gray, o); };
+        opt.board_key = key();
+    }
+
+    board_detection detect(const cv::Mat &gray, const detect_options &opt) const {
+        if (_type == BOARD_CHESSBOARD) {
+            return detect_chessboard(gray, opt);
+        }
+        board_detection det;
+        det.im_size = gray.size();
+        if (gray.empty()) {
+            return det;
+        }
+        switch (_type) {
+        case BOARD_CIRCLES:
+            det.found = cv::findCirclesGrid(gray, _size, det.corners, cv::CALIB_CB_SYMMETRIC_GRID);
+            break;
+        case BOARD_ASYMMETRIC_CIRCLES:
+            det.found = cv::findCirclesGrid(gray, _size, det.corners, cv::CALIB_CB_ASYMMETRIC_GRID);
+            break;
+        case BOARD_CHARUCO: {
+            // 检测器持有可变的内部状态，每次调用各自构造，多线程检测时互不影响
+            cv::aruco::CharucoDetector detector(*_charuco);
+            detector.detectBoard(gray, det.corners, det.ids);
+            det.found = (int)det.ids.size() == point_count();
+            // 完整检测时角点按编号排列即为完整顺序，不再需要编号；部分检测时保留编号，由 view_points 取对应的物方点
+            if (!det.found) {
+                det.found = opt.min_partial > 0 && (int)det.ids.size() >= opt.min_partial && !collinear(det.ids);
+            }
+            else {
+                std::vector<cv::Point2f> ordered(point_count());
+                for (size_t k = 0; k < det.ids.size(); ++k) {
+                    ordered[det.ids[k]] = det.corners[k];
+                }
+                det.corners.swap(ordered);
+                det.ids.clear();
+            }
+        } break;
+        default:
+            break;
+        }
+        if (!det.found) {
+            det.corners.clear();
+            det.ids.clear();
+        }
+        return det;
+    }
+
+private:
+    board_type _type;
+    cv::Size _size;
+    float _square;
+    float _marker;
+    int _dictionary;
+    std::vector<cv::Point3f> _points;
+    cv::Mat _points_mat;
+    cv::Ptr<cv::aruco::CharucoBoard> _charuco;
+};
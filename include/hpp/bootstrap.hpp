@@ -0,0 +1,94 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "hpp/incremental_calib.hpp"
+#include "hpp/parallel.hpp"
+#include "hpp/schur_calib.hpp"
+
+// 自助法估计的参数依次为 fx fy cx cy k1 k2 k3
+static const int BOOTSTRAP_PARAMS = 7;
+static const char *const BOOTSTRAP_NAMES[BOOTSTRAP_PARAMS] = {"fx", "fy", "cx", "cy", "k1", "k2", "k3"};
+
+struct bootstrap_interval {
+    double mean = 0;
+    double std = 0;
+    double lo = 0;  // 置信区间下界
+    double hi = 0;  // 置信区间上界
+};
+
+struct bootstrap_result {
+    bootstrap_interval params[BOOTSTRAP_PARAMS];
+    int samples = 0;
+    double confidence = 0;
+    double elapsed_ms = 0;
+};
+
+inline void bootstrap_params(const calib_result &r, double *out) {
+    out[0] = r.cam_mat.at<double>(0, 0);
+    out[1] = r.cam_mat.at<double>(1, 1);
+    out[2] = r.cam_mat.at<double>(0, 2);
+    out[3] = r.cam_mat.at<double>(1, 2);
+    const double *d = r.dist.ptr<double>();
+    out[4] = d[0];
+    out[5] = d[1];
+    out[6] = d[4];
+}
+
+// 自助法：有放回地重采样视图并以全量结果为初值重新标定 samples 次，各次求解在多个线程中并行，
+// 按百分位数给出 confidence 置信区间。每次重采样的随机数种子只取决于 seed 和序号，结果与线程数无关
+inline bootstrap_result bootstrap_intrinsics(const object_views &obj_points, const std::vector<std::vector<cv::Point2f> > &im_points,
+                                             cv::Size im_size, const calib_result &full, int samples, double confidence, bool schur, int threads,
+                                             uint64_t seed = 0x5eed) {
+    bootstrap_result res;
+    if (samples <= 0 || im_points.empty()) {
+        return res;
+    }
+    auto start = std::chrono::steady_clock::now();
+    const cv::TermCriteria criteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 20, 1e-6);
+    const int n = (int)im_points.size();
+    std::vector<double> values((size_t)samples * BOOTSTRAP_PARAMS);
+    // 样本级并行时关闭 OpenCV 内部的并行，避免线程数超额
+    {
+        cv_threads_guard guard(resolve_threads(threads) > 1);
+        parallel_for_index(samples, threads, [&](int s) {
+            cv::RNG rng(seed + (uint64_t)s * 0x9E3779B97F4A7C15ULL);
+            object_views obj;
+            std::vector<std::vector<cv::Point2f> > im;
+            obj.reserve(n);
+            im.reserve(n);
+            for (int k = 0; k < n; ++k) {
+                int i = rng.uniform(0, n);
+                obj.push_back(obj_points[i]);
+                im.push_back(im_points[i]);
+            }
+            calib_result r = schur ? calibrate_views_schur(obj, im, im_size, &full, criteria, 1) : calibrate_views(obj, im, im_size, &full, criteria);
+            bootstrap_params(r, &values[(size_t)s * BOOTSTRAP_PARAMS]);
+        });
+    }
+
+    res.samples = samples;
+    res.confidence = confidence;
+    std::vector<double> column(samples);
+    for (int p = 0; p < BOOTSTRAP_PARAMS; ++p) {
+        double sum = 0, sum_sq = 0;
+        for (int s = 0; s < samples; ++s) {
+            column[s] = values[(size_t)s * BOOTSTRAP_PARAMS + p];
+            sum += column[s];
+            sum_sq += column[s] * column[s];
+        }
+        std::sort(column.begin(), column.end());
+        bootstrap_interval &iv = res.params[p];
+        iv.mean = sum / samples;
+        iv.std = std::sqrt(std::max(0.0, sum_sq / samples - iv.mean * iv.mean));
+        double tail = (1 - confidence) / 2;
+        iv.lo = column[std::min(samples - 1, (int)std::floor(tail * samples))];
+        iv.hi = column[std::min(samples - 1, (int)std::floor((1 - tail) * samples))];
+    }
+    res.elapsed_ms = elapsed_ms(start);
+    return res;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// 有界阻塞队列。队列满时 push 阻塞、try_push 直接丢弃；close 后 pop 取完剩余元素即返回 false
+template <typename T> class bounded_queue {
+public:
+    explicit bounded_queue(size_t capacity) : _capacity(capacity), _closed(false) {}
+
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_full.wait(lock, [this]() { return _closed || _items.size() < _capacity; });
+        if (_closed) {
+            return false;
+        }
+        _items.push_back(std::move(item));
+        lock.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    bool try_push(T item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_closed || _items.size() >= _capacity) {
+            return false;
+        }
+        _items.push_back(std::move(item));
+        lock.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    // 剩余空间容得下全部元素时一起入队，否则一个也不入队
+    bool try_push_all(std::vector<T> items) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_closed || _items.size() + items.size() > _capacity) {
+            return false;
+        }
+        for (T &item : items) {
+            _items.push_back(std::move(item));
+        }
+        lock.unlock();
+        _not_empty.notify_all();
+        return true;
+    }
+
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [this]() { return _closed || !_items.empty(); });
+        if (_items.empty()) {
+            return false;
+        }
+        item = std::move(_items.front());
+        _items.pop_front();
+        lock.unlock();
+        _not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+        }
+        _not_full.notify_all();
+        _not_empty.notify_all();
+    }
+
+private:
+    size_t _capacity;
+    bool _closed;
+    std::deque<T> _items;
+    std::mutex _mutex;
+    std::condition_variable _not_full;
+    std::condition_variable _not_empty;
+};
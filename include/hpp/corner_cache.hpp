@@ -0,0 +1,202 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hpp/corner_detect.hpp"
+#include "hpp/parallel.hpp"
+
+// murmur3 的 64 位终结函数，每个输入位都会影响全部输出位
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// 按 8 字节一组处理：每组与当前状态异或后经 mix64 混合，末尾不足 8 字节的部分补零成一组，最后混入长度。
+// seed 传入上一段的结果即可把多段数据串接为一个哈希
+inline uint64_t content_hash(const uchar *data, size_t size, uint64_t seed = 14695981039346656037ULL) {
+    uint64_t h = seed;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = mix64(h ^ word);
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, size - i);
+        h = mix64(h ^ word);
+    }
+    return mix64(h ^ (uint64_t)size);
+}
+
+// 影响检测结果的设置：棋盘格尺寸、CALIB_CB_* 标志、由粗到精检测的层宽度及标定板模型
+inline uint64_t settings_hash(const detect_options &opt) {
+    int32_t fields[] = {opt.board_size.width, opt.board_size.height, opt.flags, opt.pyramid_width, opt.min_partial, opt.focus_step};
+    uint64_t h = content_hash((const uchar *)fields, sizeof(fields));
+    h = content_hash((const uchar *)&opt.min_focus, sizeof(opt.min_focus), h);
+    return content_hash((const uchar *)opt.board_key.data(), opt.board_key.size(), h);
+}
+
+// 磁盘上的角点缓存，以图像文件内容的哈希和检测设置为键，图像未变化时跳过检测。
+// 键与文件名无关，图像被重命名或移动后仍能命中
+class corner_cache {
+public:
+    corner_cache(const std::string &path, const detect_options &opt) : _path(path), _opt(opt), _settings(settings_hash(opt)), _hits(0), _misses(0) {
+        load();
+    }
+
+    corner_cache(const corner_cache &) = delete;
+    corner_cache &operator=(const corner_cache &) = delete;
+
+    // 多线程读取并检测全部图像，结果按 paths 的顺序返回；只有未命中的图像才会被解码和检测
+    std::vector<board_detection> detect(const std::vector<std::string> &paths) {
+        std::vector<board_detection> results(paths.size());
+        std::vector<uint64_t> hashes(paths.size(), 0);
+        std::vector<char> hit(paths.size(), 0);
+        int threads = std::min(resolve_threads(_opt.threads), (int)paths.size());
+        {
+            cv_threads_guard guard(threads > 1);
+            // 检测期间 _entries 只读，新结果在全部线程结束后再写入
+            parallel_for_index((int)paths.size(), threads, [&](int i) {
+                auto start = std::chrono::steady_clock::now();
+                std::ifstream in(paths[i], std::ios::binary);
+                std::vector<uchar> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                hashes[i] = content_hash(bytes.data(), bytes.size());
+                auto it = _entries.find(std::make_pair(hashes[i], _settings));
+                if (it != _entries.end()) {
+                    results[i] = it->second;
+                    hit[i] = 1;
+                }
+                else {
+                    // 复用已读入的文件内容解码，不再读一次磁盘
+                    cv::Mat gray = bytes.empty() ? cv::Mat() : cv::imdecode(bytes, cv::IMREAD_GRAYSCALE);
+                    results[i] = detect_board(gray, _opt);
+                }
+                results[i].detect_ms = elapsed_ms(start);
+                results[i].index = i;
+            });
+        }
+
+        _current.clear();
+        for (size_t i = 0; i < paths.size(); ++i) {
+            _current.insert(hashes[i]);
+            if (hit[i]) {
+                ++_hits;
+                continue;
+            }
+            ++_misses;
+            // 读取失败的图像不缓存
+            if (!results[i].im_size.empty()) {
+                _entries[std::make_pair(hashes[i], _settings)] = results[i];
+            }
+        }
+        return results;
+    }
+
+    // 写回缓存文件，只保留最近一次 detect 中出现过的图像（任意设置）的条目
+    bool save() {
+        cv::FileStorage fs(_path, cv::FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            std::cout << "Fail to open " << _path << std::endl;
+            return false;
+        }
+        fs << "entries" << "[";
+        for (auto &entry : _entries) {
+            if (!_current.empty() && !_current.count(entry.first.first)) {
+                continue;
+            }
+            const board_detection &det = entry.second;
+            fs << "{";
+            // FileStorage 不支持 64 位整数，哈希以十六进制字符串保存
+            fs << "content" << to_hex(entry.first.first) << "settings" << to_hex(entry.first.second);
+            fs << "width" << det.im_size.width << "height" << det.im_size.height;
+            fs << "found" << (int)det.found;
+            fs << "corners" << det.corners;
+            if (!det.ids.empty()) {
+                fs << "ids" << det.ids;
+            }
+            if (det.focus >= 0) {
+                fs << "focus" << det.focus;
+            }
+            fs << "}";
+        }
+        fs << "]";
+        return true;
+    }
+
+    int hits() const {
+        return _hits;
+    }
+
+    int misses() const {
+        return _misses;
+    }
+
+private:
+    typedef std::pair<uint64_t, uint64_t> key;
+
+    std::string _path;
+    detect_options _opt;
+    uint64_t _settings;
+    int _hits;
+    int _misses;
+    std::map<key, board_detection> _entries;
+    std::set<uint64_t> _current;
+
+    static std::string to_hex(uint64_t v) {
+        std::ostringstream buff;
+        buff << std::hex << v;
+        return buff.str();
+    }
+
+    static uint64_t from_hex(const std::string &s) {
+        uint64_t v = 0;
+        std::istringstream(s) >> std::hex >> v;
+        return v;
+    }
+
+    // 缓存文件不存在或损坏时视为空缓存
+    void load() {
+        std::ifstream probe(_path);
+        if (!probe.good()) {
+            return;
+        }
+        probe.close();
+        try {
+            cv::FileStorage fs(_path, cv::FileStorage::READ);
+            cv::FileNode entries = fs["entries"];
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                board_detection det;
+                det.im_size = cv::Size((int)(*it)["width"], (int)(*it)["height"]);
+                det.found = (int)(*it)["found"] != 0;
+                (*it)["corners"] >> det.corners;
+                if (!(*it)["ids"].empty()) {
+                    (*it)["ids"] >> det.ids;
+                }
+                if (!(*it)["focus"].empty()) {
+                    det.focus = (double)(*it)["focus"];
+                }
+                _entries[std::make_pair(from_hex((std::string)(*it)["content"]), from_hex((std::string)(*it)["settings"]))] = det;
+            }
+        }
+        catch (const cv::Exception &) {
+            std::cout << "Ignoring corrupted corner cache " << _path << std::endl;
+            _entries.clear();
+        }
+    }
+};
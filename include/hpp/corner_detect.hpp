@@ -0,0 +1,180 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hpp/focus_measure.hpp"
+#include "hpp/parallel.hpp"
+
+// 单张图像的角点检测结果
+struct board_detection {
+    int index = -1;                    // 图像序号，即 N.jpg 中的 N
+    bool found = false;                // 是否找到可用于标定的标定板，ids 非空时为部分检测
+    cv::Size im_size;                  // 图像尺寸，读取失败时为空
+    std::vector<cv::Point2f> corners;  // 角点像素坐标
+    std::vector<int> ids;              // 部分检测时各角点在标定板中的编号，完整检测时为空
+    double detect_ms = 0;              // 读取加检测耗时，单位：ms
+    double coarse_ms = 0;              // 由粗到精检测时粗检测阶段的耗时，单位：ms
+    double refine_ms = 0;              // 由粗到精检测时全分辨率精化阶段的耗时，单位：ms
+    uint64_t timestamp_usec = 0;       // 来自相机流时图像的设备时间戳，单位：us
+    double focus = -1;                 // 启用清晰度预筛时图像的清晰度评分，未计算时为 -1
+    double focus_ms = 0;               // 清晰度评分的耗时，单位：ms
+};
+
+struct detect_options {
+    cv::Size board_size;  // 棋盘格内角点的列数和行数
+    int flags = cv::CALIB_CB_EXHAUSTIVE | cv::CALIB_CB_ACCURACY;
+    int threads = 0;  // 检测线程数，0 表示使用全部核心
+    // 大于 0 时启用由粗到精检测：先在宽度不超过该值的金字塔层上找棋盘格，
+    // 再在全分辨率图像上只对各角点邻域做亚像素精化
+    int pyramid_width = 0;
+    // 非空时代替默认的棋盘格检测，例如由 board_model 按标定板类型分派；board_key 标识该检测器，参与角点缓存的键
+    std::function<board_detection(const cv::Mat &, const detect_options &)> detector;
+    std::string board_key;
+    // 大于 0 时可部分检测的标定板（ChArUco）只要检测到至少该数量且不共线的角点也视为有效，0 表示只接受完整的标定板
+    int min_partial = 0;
+    // 大于 0 时先计算整幅图像的清晰度（focus_measure），低于该值的模糊图像不做角点检测，直接视为未找到
+    double min_focus = 0;
+    int focus_step = 2;  // 清晰度评分的采样间隔
+};
+
+inline double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 相邻角点间的最小像素距离
+inline float min_corner_spacing(const std::vector<cv::Point2f> &corners, cv::Size board_size) {
+    float spacing = FLT_MAX;
+    for (int r = 0; r < board_size.height; ++r) {
+        for (int c = 0; c < board_size.width; ++c) {
+            const cv::Point2f &p = corners[r * board_size.width + c];
+            if (c + 1 < board_size.width) {
+                spacing = std::min(spacing, (float)cv::norm(p - corners[r * board_size.width + c + 1]));
+            }
+            if (r + 1 < board_size.height) {
+                spacing = std::min(spacing, (float)cv::norm(p - corners[(r + 1) * board_size.width + c]));
+            }
+        }
+    }
+    return spacing;
+}
+
+// 由粗到精检测。没有棋盘格的图像在最小层上由 checkChessboard 快速排除
+inline board_detection detect_board_pyramid(const cv::Mat &gray, const detect_options &opt) {
+    board_detection det;
+    det.im_size = gray.size();
+    if (gray.empty()) {
+        return det;
+    }
+    auto start = std::chrono::steady_clock::now();
+    cv::Mat coarse = gray;
+    int scale = 1;
+    while (coarse.cols > opt.pyramid_width) {
+        cv::pyrDown(coarse, coarse);
+        scale *= 2;
+    }
+    if (!cv::checkChessboard(coarse, opt.board_size) ||
+        !cv::findChessboardCornersSB(coarse, opt.board_size, det.corners, opt.flags & ~cv::CALIB_CB_ACCURACY)) {
+        det.corners.clear();
+        det.coarse_ms = elapsed_ms(start);
+        return det;
+    }
+    det.coarse_ms = elapsed_ms(start);
+
+    // pyrDown 后第 i 个像素对应原图第 2i 个像素，直接按比例放大即可
+    start = std::chrono::steady_clock::now();
+    for (auto &p : det.corners) {
+        p *= (float)scale;
+    }
+    // 精化窗口不超过半个格子，避免窗口覆盖到相邻角点
+    int half_win = std::max(2, std::min((int)(min_corner_spacing(det.corners, opt.board_size) * 0.4f), 4 * scale));
+    cv::cornerSubPix(gray, det.corners, cv::Size(half_win, half_win), cv::Size(-1, -1),
+                     cv::TermCriteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 30, 0.01));
+    det.refine_ms = elapsed_ms(start);
+    det.found = true;
+    return det;
+}
+
+// 按 grasp 的命名规则列出 dir/0.jpg, dir/1.jpg ...，遇到第一个不存在的序号即停止
+inline std::vector<std::string> list_images(const std::string &dir) {
+    std::vector<std::string> paths;
+    for (int count = 0;; ++count) {
+        std::stringstream buffer;
+        buffer << dir << count << ".jpg";
+        if (!std::ifstream(buffer.str()).good()) {
+            break;
+        }
+        paths.push_back(buffer.str());
+    }
+    return paths;
+}
+
+// 在一张灰度图中检测棋盘格
+inline board_detection detect_chessboard(const cv::Mat &gray, const detect_options &opt) {
+    if (opt.pyramid_width > 0) {
+        return detect_board_pyramid(gray, opt);
+    }
+    board_detection det;
+    det.im_size = gray.size();
+    if (!gray.empty()) {
+        det.found = cv::findChessboardCornersSB(gray, opt.board_size, det.corners, opt.flags);
+    }
+    if (!det.found) {
+        det.corners.clear();
+    }
+    return det;
+}
+
+// 在一张灰度图中检测标定板，未指定 detector 时按棋盘格检测
+inline board_detection detect_board(const cv::Mat &gray, const detect_options &opt) {
+    if (opt.min_focus > 0 && !gray.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        double focus = focus_measure(gray, opt.focus_step);
+        double focus_ms = elapsed_ms(start);
+        board_detection det;
+        if (focus < opt.min_focus) {
+            det.im_size = gray.size();
+        }
+        else {
+            det = opt.detector ? opt.detector(gray, opt) : detect_chessboard(gray, opt);
+        }
+        det.focus = focus;
+        det.focus_ms = focus_ms;
+        return det;
+    }
+    if (opt.detector) {
+        return opt.detector(gray, opt);
+    }
+    return detect_chessboard(gray, opt);
+}
+
+// 读取并检测一张图像。findChessboardCornersSB 也接受 8 位彩色图，但检测只用到亮度，
+// 直接解码为灰度可省去彩色解码和颜色转换
+inline board_detection detect_board(const std::string &path, const detect_options &opt) {
+    auto start = std::chrono::steady_clock::now();
+    board_detection det = detect_board(cv::imread(path, cv::IMREAD_GRAYSCALE), opt);
+    det.detect_ms = elapsed_ms(start);
+    return det;
+}
+
+// 多线程检测全部图像，结果按 paths 的顺序返回
+inline std::vector<board_detection> detect_boards(const std::vector<std::string> &paths, const detect_options &opt) {
+    std::vector<board_detection> results(paths.size());
+    int threads = std::min(resolve_threads(opt.threads), (int)paths.size());
+    // 图像级并行时关闭 OpenCV 内部的并行，避免线程数超额
+    {
+        cv_threads_guard guard(threads > 1);
+        parallel_for_index((int)paths.size(), threads, [&](int i) {
+            results[i] = detect_board(paths[i], opt);
+            results[i].index = i;
+        });
+    }
+    return results;
+}
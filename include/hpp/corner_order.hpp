@@ -0,0 +1,175 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "hpp/board_model.hpp"
+
+// 按标定板的对称排列重排一个完整检测的角点：第 k 个角点放到 perm[k] 处，使其与物方点 perm[k] 对应
+inline std::vector<cv::Point2f> reorder_corners(const std::vector<cv::Point2f> &corners, const std::vector<int> &perm) {
+    std::vector<cv::Point2f> out(corners.size());
+    for (size_t k = 0; k < corners.size(); ++k) {
+        out[perm[k]] = corners[k];
+    }
+    return out;
+}
+
+// 两个旋转之间的夹角，单位：度
+inline double rotation_angle_deg(const cv::Matx33d &a, const cv::Matx33d &b) {
+    cv::Matx33d d = a * b.t();
+    double c = (d(0, 0) + d(1, 1) + d(2, 2) - 1) / 2;
+    return std::acos(std::max(-1.0, std::min(1.0, c))) * 180 / CV_PI;
+}
+
+// 多台相机同时观测同一块标定板时，对称的图案在各相机中可能从不同的角开始排列，直接共用物方点会得到矛盾的位姿。
+// View 为一次同步观测，含 cameras、obj_points、im_points 三个成员，每台相机至多一个。
+// 各相机由 initCameraMatrix2D 得到粗略内参，求出每个观测在每种对称排列下标定板相对该相机的旋转；
+// 相机之间的相对旋转取各观测中最一致的一个（从相机 0 出发，经共同观测逐台确定），
+// 再把每个观测中其他相机的角点重排为与该观测第一台相机一致的顺序。
+// 任何排列下相对旋转都与之相差超过 max_angle_deg 的检测从观测中去掉，返回去掉的个数
+template <class View>
+inline int align_corner_orders(std::vector<View> &views, const board_model &board, const std::vector<cv::Size> &im_sizes, double max_angle_deg = 20) {
+    const int n_cam = (int)im_sizes.size();
+    const int n = (int)views.size();
+    const std::vector<std::vector<int> > perms = board.symmetries();
+
+    std::vector<std::vector<cv::Mat> > mono_obj(n_cam);
+    std::vector<std::vector<std::vector<cv::Point2f> > > mono_im(n_cam);
+    for (const View &v : views) {
+        for (size_t k = 0; k < v.cameras.size(); ++k) {
+            mono_obj[v.cameras[k]].push_back(v.obj_points[k]);
+            mono_im[v.cameras[k]].push_back(v.im_points[k]);
+        }
+    }
+    std::vector<cv::Mat> K(n_cam);
+    for (int c = 0; c < n_cam; ++c) {
+        if (!mono_im[c].empty()) {
+            K[c] = cv::initCameraMatrix2D(mono_obj[c], mono_im[c], im_sizes[c]);
+        }
+    }
+
+    // rot[g][k][s]：第 g 个观测中第 k 台相机的角点按第 s 种排列重排后，标定板相对该相机的旋转。部分检测只有恒等排列，
+    // 不足 4 个点时为空
+    std::vector<std::vector<std::vector<cv::Matx33d> > > rot(n);
+    for (int g = 0; g < n; ++g) {
+        const View &v = views[g];
+        rot[g].resize(v.cameras.size());
+        for (size_t k = 0; k < v.cameras.size(); ++k) {
+            // solvePnP 至少需要 4 个点，更少的部分检测不参与比较，保持原样
+            if (v.im_points[k].size() < 4) {
+                continue;
+            }
+            const bool full = (int)v.im_points[k].size() == board.point_count();
+            for (size_t s = 0; s < (full ? perms.size() : 1); ++s) {
+                cv::Vec3d rvec, tvec;
+                cv::solvePnP(v.obj_points[k], s == 0 ? v.im_points[k] : reorder_corners(v.im_points[k], perms[s]), K[v.cameras[k]], cv::noArray(),
+                             rvec, tvec, false, cv::SOLVEPNP_IPPE);
+                cv::Matx33d R;
+                cv::Rodrigues(rvec, R);
+                rot[g][k].push_back(R);
+            }
+        }
+    }
+
+    // 各相机相对相机 0 的旋转 rel[c]：X_c = rel[c] * X_0。
+    // 对每台未确定的相机，候选为每个共同观测的每种排列给出的相对旋转，取与最多观测一致的候选
+    std::vector<cv::Matx33d> rel(n_cam, cv::Matx33d::eye());
+    std::vector<bool> known(n_cam, false);
+    known[0] = true;
+    for (bool grown = true; grown;) {
+        grown = false;
+        for (int c = 1; c < n_cam; ++c) {
+            if (known[c]) {
+                continue;
+            }
+            std::vector<std::vector<cv::Matx33d> > candidates;
+            for (int g = 0; g < n; ++g) {
+                const std::vector<int> &cams = views[g].cameras;
+                int kc = (int)(std::find(cams.begin(), cams.end(), c) - cams.begin());
+                int ka = 0;
+                while (ka < (int)cams.size() && (!known[cams[ka]] || rot[g][ka].empty())) {
+                    ++ka;
+                }
+                if (kc == (int)cams.size() || ka == (int)cams.size() || rot[g][kc].empty()) {
+                    continue;
+                }
+                std::vector<cv::Matx33d> cand;
+                for (const cv::Matx33d &R : rot[g][kc]) {
+                    cand.push_back(R * rot[g][ka][0].t() * rel[cams[ka]]);
+                }
+                candidates.push_back(cand);
+            }
+            int best_support = 0;
+            for (const std::vector<cv::Matx33d> &cand : candidates) {
+                for (const cv::Matx33d &R : cand) {
+                    int support = 0;
+                    for (const std::vector<cv::Matx33d> &other : candidates) {
+                        for (const cv::Matx33d &R2 : other) {
+                            if (rotation_angle_deg(R, R2) < max_angle_deg) {
+                                ++support;
+                                break;
+                            }
+                        }
+                    }
+                    if (support > best_support) {
+                        best_support = support;
+                        rel[c] = R;
+                    }
+                }
+            }
+            if (best_support > 0) {
+                known[c] = true;
+                grown = true;
+            }
+        }
+    }
+
+    // 每个观测以第一台已确定的相机为准，其他相机取相对旋转最接近 rel 的排列。
+    // 与相机 0 没有共同观测的相机保持原样，由后续标定报告
+    int dropped = 0;
+    for (int g = 0; g < n; ++g) {
+        View &v = views[g];
+        int ref = 0;
+        while (ref < (int)v.cameras.size() && (!known[v.cameras[ref]] || rot[g][ref].empty())) {
+            ++ref;
+        }
+        if (ref == (int)v.cameras.size()) {
+            continue;
+        }
+        const cv::Matx33d expected_ref = rel[v.cameras[ref]];
+        std::vector<bool> keep(v.cameras.size(), true);
+        for (int k = 0; k < (int)v.cameras.size(); ++k) {
+            const int c = v.cameras[k];
+            if (k == ref || !known[c] || rot[g][k].empty()) {
+                continue;
+            }
+            const cv::Matx33d expected = rel[c] * expected_ref.t();
+            double best = 180;
+            size_t best_s = 0;
+            for (size_t s = 0; s < rot[g][k].size(); ++s) {
+                double angle = rotation_angle_deg(rot[g][k][s] * rot[g][ref][0].t(), expected);
+                if (angle < best) {
+                    best = angle;
+                    best_s = s;
+                }
+            }
+            if (best > max_angle_deg) {
+                keep[k] = false;
+            }
+            else if (best_s > 0) {
+                v.im_points[k] = reorder_corners(v.im_points[k], perms[best_s]);
+            }
+        }
+        for (int k = (int)v.cameras.size() - 1; k >= 0; --k) {
+            if (!keep[k]) {
+                v.cameras.erase(v.cameras.begin() + k);
+                v.obj_points.erase(v.obj_points.begin() + k);
+                v.im_points.erase(v.im_points.begin() + k);
+                ++dropped;
+            }
+        }
+    }
+    return dropped;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "hpp/bounded_queue.hpp"
+#include "hpp/corner_detect.hpp"
+
+// 采集到检测的流水线：采集线程提交灰度帧，检测线程从有界队列中取帧检测并保留有效结果。
+// on_board 非空时在检测线程中对每个有效结果调用一次，例如用于增量标定
+class corner_pipeline {
+public:
+    corner_pipeline(const detect_options &opt, size_t capacity, std::function<void(const board_detection &)> on_board = nullptr)
+        : _opt(opt), _queue(capacity), _submitted(0), _dropped(0), _finished(false), _on_board(on_board) {
+        _worker = std::thread(&corner_pipeline::run, this);
+    }
+
+    ~corner_pipeline() {
+        finish();
+    }
+
+    corner_pipeline(const corner_pipeline &) = delete;
+    corner_pipeline &operator=(const corner_pipeline &) = delete;
+
+    // block 为 false 时队列满则丢弃该帧并返回 false
+    bool push(const cv::Mat &gray, uint64_t timestamp_usec, bool block) {
+        frame f;
+        f.gray = gray;
+        f.index = _submitted++;
+        f.timestamp_usec = timestamp_usec;
+        bool ok = block ? _queue.push(f) : _queue.try_push(f);
+        if (!ok) {
+            ++_dropped;
+        }
+        return ok;
+    }
+
+    // 等待队列中的帧全部检测完毕，返回有效的检测结果
+    const std::vector<board_detection> &finish() {
+        if (!_finished) {
+            _finished = true;
+            _queue.close();
+            _worker.join();
+        }
+        return _detections;
+    }
+
+    int submitted() const {
+        return _submitted;
+    }
+
+    int dropped() const {
+        return _dropped;
+    }
+
+    cv::Size image_size() const {
+        return _im_size;
+    }
+
+private:
+    struct frame {
+        cv::Mat gray;
+        int index;
+        uint64_t timestamp_usec;
+    };
+
+    detect_options _opt;
+    bounded_queue<frame> _queue;
+    std::atomic<int> _submitted;
+    std::atomic<int> _dropped;
+    bool _finished;
+    std::function<void(const board_detection &)> _on_board;
+    cv::Size _im_size;
+    std::vector<board_detection> _detections;
+    std::thread _worker;
+
+    void run() {
+        frame f;
+        while (_queue.pop(f)) {
+            auto start = std::chrono::steady_clock::now();
+            board_detection det = detect_board(f.gray, _opt);
+            det.detect_ms = elapsed_ms(start);
+            det.index = f.index;
+            det.timestamp_usec = f.timestamp_usec;
+            _im_size = det.im_size;
+            if (det.found) {
+                _detections.push_back(det);
+                if (_on_board) {
+                    _on_board(det);
+                }
+            }
+        }
+    }
+};
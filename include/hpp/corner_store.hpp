@@ -0,0 +1,60 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "hpp/corner_detect.hpp"
+
+// 角点文件：保存每个有效视图的角点及元数据，代替原始图像供 calibrate 使用
+inline bool save_corners(const std::string &path, cv::Size board_size, cv::Size im_size, const std::vector<board_detection> &detections) {
+    cv::FileStorage fs(path, cv::FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        std::cout << "Fail to open " << path << std::endl;
+        return false;
+    }
+    fs << "board_cols" << board_size.width << "board_rows" << board_size.height;
+    fs << "image_width" << im_size.width << "image_height" << im_size.height;
+    fs << "views" << "[";
+    for (auto &det : detections) {
+        if (!det.found) {
+            continue;
+        }
+        fs << "{";
+        fs << "index" << det.index;
+        // FileStorage 不支持 64 位整数，微秒时间戳以 double 保存
+        fs << "timestamp_usec" << (double)det.timestamp_usec;
+        fs << "detect_ms" << det.detect_ms;
+        fs << "corners" << det.corners;
+        fs << "}";
+    }
+    fs << "]";
+    return true;
+}
+
+// 读取角点文件，棋盘格尺寸与 board_size 不一致时返回 false
+inline bool load_corners(const std::string &path, cv::Size board_size, cv::Size &im_size, std::vector<board_detection> &detections) {
+    cv::FileStorage fs(path, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cout << "Fail to open " << path << std::endl;
+        return false;
+    }
+    if ((int)fs["board_cols"] != board_size.width || (int)fs["board_rows"] != board_size.height) {
+        std::cout << path << " was recorded with a different board size" << std::endl;
+        return false;
+    }
+    im_size = cv::Size((int)fs["image_width"], (int)fs["image_height"]);
+    detections.clear();
+    cv::FileNode views = fs["views"];
+    for (auto it = views.begin(); it != views.end(); ++it) {
+        board_detection det;
+        det.index = (int)(*it)["index"];
+        det.timestamp_usec = (uint64_t)(double)(*it)["timestamp_usec"];
+        det.detect_ms = (double)(*it)["detect_ms"];
+        (*it)["corners"] >> det.corners;
+        det.im_size = im_size;
+        det.found = (int)det.corners.size() == board_size.area();
+        detections.push_back(det);
+    }
+    return true;
+}
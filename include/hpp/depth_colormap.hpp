@@ -0,0 +1,124 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 由 0~255 灰度到 COLORMAP_JET 颜色的 256x1 查找表，只计算一次
+inline const cv::Mat &jet_lut() {
+    static const cv::Mat lut = []() {
+        cv::Mat ramp(256, 1, CV_8UC1), lut;
+        for (int i = 0; i < 256; ++i) {
+            ramp.at<uchar>(i) = (uchar)i;
+        }
+        cv::applyColorMap(ramp, lut, cv::COLORMAP_JET);
+        return lut;
+    }();
+    return lut;
+}
+
+// 深度图到 JET 伪彩色的单遍转换：near 及以下为表首颜色，far 及以上为表尾颜色。
+// 每行先用 SIMD 以定点数算出 0~255 的索引，再查 256 项的 BGR 表，代替缩放、convertTo、applyColorMap 三遍处理
+class depth_colormap {
+public:
+    explicit depth_colormap(float near_mm = 0, float far_mm = 6000) : _near_mm(near_mm), _far_mm(far_mm) {
+        std::memcpy(_lut, jet_lut().data, sizeof(_lut));
+    }
+
+    void set_range(float near_mm, float far_mm) {
+        _near_mm = near_mm;
+        _far_mm = far_mm;
+    }
+
+    // depth 为 CV_16UC1，value_scale 为 ob2::image::get_value_scale()，即每个原始值代表的毫米数
+    void apply(const cv::Mat &depth, float value_scale, cv::Mat &bgr) const {
+        run(depth, value_scale, bgr, true);
+    }
+
+    // 不使用 SIMD 的参考实现
+    void apply_scalar(const cv::Mat &depth, float value_scale, cv::Mat &bgr) const {
+        run(depth, value_scale, bgr, false);
+    }
+
+private:
+    float _near_mm;
+    float _far_mm;
+    uchar _lut[256 * 3];
+
+    void run(const cv::Mat &depth, float value_scale, cv::Mat &bgr, bool simd) const {
+        CV_Assert(depth.type() == CV_16UC1);
+        bgr.create(depth.size(), CV_8UC3);
+        // 换算到原始值：index = min(max(v - near, 0), range) * mul >> 16
+        uint32_t near_raw = (uint32_t)std::min(std::max(_near_mm / value_scale + 0.5f, 0.f), 65535.f);
+        uint32_t range = (uint32_t)std::min(std::max((_far_mm - _near_mm) / value_scale + 0.5f, 1.f), 65535.f);
+        uint32_t mul = (uint32_t)(255.0 * 65536 / range);
+        // 乘数超出 16 位时（量程小于 256 个原始值）只能走标量路径
+        simd = simd && mul <= 65535;
+        cv::parallel_for_(cv::Range(0, depth.rows), [&](const cv::Range &rows) {
+            uchar idx[256];
+            for (int y = rows.start; y < rows.end; ++y) {
+                const uint16_t *src = depth.ptr<uint16_t>(y);
+                uchar *dst = bgr.ptr<uchar>(y);
+                for (int x0 = 0; x0 < depth.cols; x0 += 256) {
+                    int n = std::min(256, depth.cols - x0);
+                    int x = simd ? index_simd(src + x0, idx, n, near_raw, range, mul) : 0;
+                    for (; x < n; ++x) {
+                        uint32_t v = src[x0 + x];
+                        uint32_t d = std::min(v > near_raw ? v - near_raw : 0, range);
+                        idx[x] = (uchar)((d * mul) >> 16);
+                    }
+                    uchar *out = dst + x0 * 3;
+                    for (int i = 0; i < n; ++i) {
+                        const uchar *c = _lut + idx[i] * 3;
+                        out[i * 3] = c[0];
+                        out[i * 3 + 1] = c[1];
+                        out[i * 3 + 2] = c[2];
+                    }
+                }
+            }
+        }, depth.rows / 64.0);
+    }
+
+    // 返回已处理的像素数，剩余部分由标量代码处理
+    static int index_simd(const uint16_t *src, uchar *idx, int n, uint32_t near_raw, uint32_t range, uint32_t mul) {
+        int x = 0;
+#if defined(__AVX2__)
+        __m256i vnear = _mm256_set1_epi16((short)near_raw);
+        __m256i vrange = _mm256_set1_epi16((short)range);
+        __m256i vmul = _mm256_set1_epi16((short)mul);
+        for (; x + 16 <= n; x += 16) {
+            __m256i d = _mm256_subs_epu16(_mm256_loadu_si256((const __m256i *)(src + x)), vnear);
+            d = _mm256_min_epu16(d, vrange);
+            __m256i r = _mm256_mulhi_epu16(d, vmul);
+            // packus 在每个 128 位通道内交错，重排后低 128 位即为 16 个索引
+            __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(r, r), 0xD8);
+            _mm_storeu_si128((__m128i *)(idx + x), _mm256_castsi256_si128(p));
+        }
+#elif defined(__SSE2__)
+        __m128i vnear = _mm_set1_epi16((short)near_raw);
+        __m128i vrange = _mm_set1_epi16((short)range);
+        __m128i vmul = _mm_set1_epi16((short)mul);
+        for (; x + 8 <= n; x += 8) {
+            __m128i d = _mm_subs_epu16(_mm_loadu_si128((const __m128i *)(src + x)), vnear);
+            // SSE2 没有无符号 16 位 min：min(d, range) = range - max(range - d, 0)
+            d = _mm_sub_epi16(vrange, _mm_subs_epu16(vrange, d));
+            __m128i r = _mm_mulhi_epu16(d, vmul);
+            _mm_storel_epi64((__m128i *)(idx + x), _mm_packus_epi16(r, r));
+        }
+#else
+        (void)src;
+        (void)idx;
+        (void)n;
+        (void)near_raw;
+        (void)range;
+        (void)mul;
+#endif
+        return x;
+    }
+};
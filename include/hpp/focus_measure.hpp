@@ -0,0 +1,136 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 一行采样点的拉普拉斯响应 4c - l - r - u - d（邻点间隔 step 像素）的和与平方和。
+// up、mid、down 指向三行中第一个采样点，共 n 个采样点，间隔为 step；span 为 mid 之后可读的字节数
+inline void focus_row(const uchar *up, const uchar *mid, const uchar *down, int n, int step, int span, int64_t &sum, int64_t &sq) {
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i vsum = _mm256_setzero_si256(), vsq = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    if (step == 1) {
+        const __m256i zero = _mm256_setzero_si256();
+        // 每次 32 个采样点，先扩展为 16 位，两半分别计算
+        for (; i + 32 + 1 <= span; i += 32) {
+            __m256i c = _mm256_loadu_si256((const __m256i *)(mid + i));
+            __m256i l = _mm256_loadu_si256((const __m256i *)(mid + i - 1));
+            __m256i r = _mm256_loadu_si256((const __m256i *)(mid + i + 1));
+            __m256i u = _mm256_loadu_si256((const __m256i *)(up + i));
+            __m256i d = _mm256_loadu_si256((const __m256i *)(down + i));
+            for (int half = 0; half < 2; ++half) {
+                __m256i c16 = half ? _mm256_unpackhi_epi8(c, zero) : _mm256_unpacklo_epi8(c, zero);
+                __m256i n16 = _mm256_add_epi16(half ? _mm256_unpackhi_epi8(l, zero) : _mm256_unpacklo_epi8(l, zero),
+                                               half ? _mm256_unpackhi_epi8(r, zero) : _mm256_unpacklo_epi8(r, zero));
+                n16 = _mm256_add_epi16(n16, half ? _mm256_unpackhi_epi8(u, zero) : _mm256_unpacklo_epi8(u, zero));
+                n16 = _mm256_add_epi16(n16, half ? _mm256_unpackhi_epi8(d, zero) : _mm256_unpacklo_epi8(d, zero));
+                __m256i lap = _mm256_sub_epi16(_mm256_slli_epi16(c16, 2), n16);
+                vsum = _mm256_add_epi32(vsum, _mm256_madd_epi16(lap, ones));
+                vsq = _mm256_add_epi32(vsq, _mm256_madd_epi16(lap, lap));
+            }
+        }
+    }
+    else if (step == 2) {
+        // 间隔 2 时偶数字节即采样点，屏蔽奇数字节后直接得到 16 位的值，不需要扩展
+        const __m256i mask = _mm256_set1_epi16(0x00ff);
+        for (; 2 * i + 32 + 2 <= span; i += 16) {
+            const uchar *p = mid + 2 * i;
+            __m256i c = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p), mask);
+            __m256i n16 = _mm256_add_epi16(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(p - 2)), mask),
+                                           _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(p + 2)), mask));
+            n16 = _mm256_add_epi16(n16, _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(up + 2 * i)), mask));
+            n16 = _mm256_add_epi16(n16, _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(down + 2 * i)), mask));
+            __m256i lap = _mm256_sub_epi16(_mm256_slli_epi16(c, 2), n16);
+            vsum = _mm256_add_epi32(vsum, _mm256_madd_epi16(lap, ones));
+            vsq = _mm256_add_epi32(vsq, _mm256_madd_epi16(lap, lap));
+        }
+    }
+    int32_t s32[8], q32[8];
+    _mm256_storeu_si256((__m256i *)s32, vsum);
+    _mm256_storeu_si256((__m256i *)q32, vsq);
+    for (int k = 0; k < 8; ++k) {
+        sum += s32[k];
+        sq += (uint32_t)q32[k];
+    }
+#elif defined(__SSE2__)
+    __m128i vsum = _mm_setzero_si128(), vsq = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    if (step == 1) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 + 1 <= span; i += 16) {
+            __m128i c = _mm_loadu_si128((const __m128i *)(mid + i));
+            __m128i l = _mm_loadu_si128((const __m128i *)(mid + i - 1));
+            __m128i r = _mm_loadu_si128((const __m128i *)(mid + i + 1));
+            __m128i u = _mm_loadu_si128((const __m128i *)(up + i));
+            __m128i d = _mm_loadu_si128((const __m128i *)(down + i));
+            for (int half = 0; half < 2; ++half) {
+                __m128i c16 = half ? _mm_unpackhi_epi8(c, zero) : _mm_unpacklo_epi8(c, zero);
+                __m128i n16 = _mm_add_epi16(half ? _mm_unpackhi_epi8(l, zero) : _mm_unpacklo_epi8(l, zero),
+                                            half ? _mm_unpackhi_epi8(r, zero) : _mm_unpacklo_epi8(r, zero));
+                n16 = _mm_add_epi16(n16, half ? _mm_unpackhi_epi8(u, zero) : _mm_unpacklo_epi8(u, zero));
+                n16 = _mm_add_epi16(n16, half ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero));
+                __m128i lap = _mm_sub_epi16(_mm_slli_epi16(c16, 2), n16);
+                vsum = _mm_add_epi32(vsum, _mm_madd_epi16(lap, ones));
+                vsq = _mm_add_epi32(vsq, _mm_madd_epi16(lap, lap));
+            }
+        }
+    }
+    else if (step == 2) {
+        const __m128i mask = _mm_set1_epi16(0x00ff);
+        for (; 2 * i + 16 + 2 <= span; i += 8) {
+            const uchar *p = mid + 2 * i;
+            __m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i *)p), mask);
+            __m128i n16 = _mm_add_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i *)(p - 2)), mask),
+                                        _mm_and_si128(_mm_loadu_si128((const __m128i *)(p + 2)), mask));
+            n16 = _mm_add_epi16(n16, _mm_and_si128(_mm_loadu_si128((const __m128i *)(up + 2 * i)), mask));
+            n16 = _mm_add_epi16(n16, _mm_and_si128(_mm_loadu_si128((const __m128i *)(down + 2 * i)), mask));
+            __m128i lap = _mm_sub_epi16(_mm_slli_epi16(c, 2), n16);
+            vsum = _mm_add_epi32(vsum, _mm_madd_epi16(lap, ones));
+            vsq = _mm_add_epi32(vsq, _mm_madd_epi16(lap, lap));
+        }
+    }
+    int32_t s32[4], q32[4];
+    _mm_storeu_si128((__m128i *)s32, vsum);
+    _mm_storeu_si128((__m128i *)q32, vsq);
+    for (int k = 0; k < 4; ++k) {
+        sum += s32[k];
+        sq += (uint32_t)q32[k];
+    }
+#endif
+    for (; i < n; ++i) {
+        int x = i * step;
+        int lap = 4 * mid[x] - mid[x - step] - mid[x + step] - up[x] - down[x];
+        sum += lap;
+        sq += lap * lap;
+    }
+}
+
+// 清晰度评分：在每隔 step 个像素取一点的降采样灰度视图上计算拉普拉斯响应的方差，模糊时边缘变弱，方差随之下降。
+// 直接按间隔读取原图，不生成降采样图像，也不分配内存；step 为 1、2 时使用 SIMD，其它值使用标量实现。
+// 目标是 1080p 图像在 1 ms 内完成，实际耗时用 bench_focus 测量。gray 可以是 ROI
+inline double focus_measure(const cv::Mat &gray, int step = 2) {
+    CV_Assert(gray.type() == CV_8UC1);
+    step = std::max(1, step);
+    // 采样点的坐标为 step, 2 * step, ...，左右上下的邻点都须在图像内
+    const int n = (gray.cols - 1) / step - 1;
+    const int m = (gray.rows - 1) / step - 1;
+    if (n <= 0 || m <= 0) {
+        return 0;
+    }
+    int64_t sum = 0, sq = 0;
+    for (int j = 1; j <= m; ++j) {
+        int y = j * step;
+        // 一行的平方和在 32 位通道中累加，行宽不超过 8192 时不会溢出，每行结束后并入 64 位
+        focus_row(gray.ptr<uchar>(y - step) + step, gray.ptr<uchar>(y) + step, gray.ptr<uchar>(y + step) + step, n, step, gray.cols - step, sum, sq);
+    }
+    double count = (double)n * m;
+    double mean = sum / count;
+    return sq / count - mean * mean;
+}
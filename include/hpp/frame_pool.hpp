@@ -0,0 +1,72 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// 按 (宽, 高, 类型) 复用的帧缓冲池。
+// 池中的 Mat 只被池本身引用时视为空闲；调用方丢弃 acquire 返回的 Mat 后缓冲即自动归还，无需显式释放
+class frame_pool {
+public:
+    frame_pool() : _hits(0), _misses(0), _live_bytes(0) {}
+
+    frame_pool(const frame_pool &) = delete;
+    frame_pool &operator=(const frame_pool &) = delete;
+
+    cv::Mat acquire(cv::Size size, int type) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<cv::Mat> &mats = _pool[std::make_tuple(size.width, size.height, type)];
+        for (auto &m : mats) {
+            if (m.u->refcount == 1) {
+                ++_hits;
+                return m;
+            }
+        }
+        ++_misses;
+        mats.push_back(cv::Mat(size, type));
+        _live_bytes += mats.back().total() * mats.back().elemSize();
+        return mats.back();
+    }
+
+    // 释放当前空闲的缓冲，例如分辨率切换之后
+    void trim() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &entry : _pool) {
+            std::vector<cv::Mat> &mats = entry.second;
+            for (size_t i = 0; i < mats.size();) {
+                if (mats[i].u->refcount == 1) {
+                    _live_bytes -= mats[i].total() * mats[i].elemSize();
+                    mats.erase(mats.begin() + i);
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+    }
+
+    size_t hits() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _hits;
+    }
+
+    size_t misses() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _misses;
+    }
+
+    // 池中所有缓冲（含正在使用的）占用的字节数
+    size_t live_bytes() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _live_bytes;
+    }
+
+private:
+    std::mutex _mutex;
+    std::map<std::tuple<int, int, int>, std::vector<cv::Mat>> _pool;
+    size_t _hits;
+    size_t _misses;
+    size_t _live_bytes;
+};
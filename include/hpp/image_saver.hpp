@@ -0,0 +1,95 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hpp/bounded_queue.hpp"
+
+// 在后台线程中把采集到的图像写入 dir，默认按序号命名为 N.jpg，显示线程只负责提交
+class image_saver {
+public:
+    image_saver(const std::string &dir, size_t capacity) : _dir(dir), _queue(capacity), _next(0), _written(0), _failed(0) {
+        if (!_dir.empty() && _dir.back() != '/') {
+            _dir += '/';
+        }
+        _worker = std::thread(&image_saver::run, this);
+    }
+
+    // 析构时写完队列中剩余的图像
+    ~image_saver() {
+        _queue.close();
+        _worker.join();
+    }
+
+    image_saver(const image_saver &) = delete;
+    image_saver &operator=(const image_saver &) = delete;
+
+    // 队列满时丢弃该帧并返回 false；im 在写完之前不能被修改
+    bool push(const cv::Mat &im, int index) {
+        std::ostringstream name;
+        name << index << ".jpg";
+        return push(im, name.str());
+    }
+
+    // 按入队顺序命名为 N.jpg，序号只在入队成功时占用，多个线程同时提交时也不会重号或留空号；
+    // 队列满时返回 false
+    bool push_next(const cv::Mat &im) {
+        std::lock_guard<std::mutex> lock(_next_mutex);
+        if (!push(im, _next)) {
+            return false;
+        }
+        ++_next;
+        return true;
+    }
+
+    // 以 name 为文件名写入，格式由扩展名决定
+    bool push(const cv::Mat &im, const std::string &name) {
+        return _queue.try_push({im, name});
+    }
+
+    // 成对写入，两张图像要么都入队、要么都不入队，不会留下缺少另一半的文件
+    bool push_pair(const cv::Mat &first, const std::string &first_name, const cv::Mat &second, const std::string &second_name) {
+        return _queue.try_push_all({{first, first_name}, {second, second_name}});
+    }
+
+    int written() const {
+        return _written;
+    }
+
+    int failed() const {
+        return _failed;
+    }
+
+private:
+    struct job {
+        cv::Mat im;
+        std::string name;
+    };
+
+    std::string _dir;
+    bounded_queue<job> _queue;
+    std::mutex _next_mutex;
+    int _next;
+    std::atomic<int> _written;
+    std::atomic<int> _failed;
+    std::thread _worker;
+
+    void run() {
+        job j;
+        while (_queue.pop(j)) {
+            if (!cv::imwrite(_dir + j.name, j.im, std::vector<int>({cv::IMWRITE_JPEG_QUALITY, 100}))) {
+                std::cout << "\nFail to write the file" << std::endl;
+                ++_failed;
+            }
+            else {
+                ++_written;
+            }
+            j.im.release();
+        }
+    }
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+
+#include "hpp/OB2Camera.hpp"
+
+// 按图像格式把 buffer 包装为 cv::Mat，不复制数据；stride 为 0 时按紧密排列处理，不支持的格式返回空 Mat
+inline cv::Mat wrap_image_buffer(void *data, uint32_t size, ob2_image_format_t format, uint32_t width, uint32_t height, uint32_t stride) {
+    size_t step = stride ? stride : cv::Mat::AUTO_STEP;
+    switch (format) {
+    case OB2_FORMAT_MJPG:
+        return cv::Mat(1, size, CV_8UC1, data);
+    case OB2_FORMAT_YUYV:
+        return cv::Mat(height, width, CV_8UC2, data, step);
+    case OB2_FORMAT_NV12:
+        // Y 平面后紧跟交错的 UV 平面，共 height * 3 / 2 行
+        return cv::Mat(height * 3 / 2, width, CV_8UC1, data, step);
+    case OB2_FORMAT_RGB:
+        return cv::Mat(height, width, CV_8UC3, data, step);
+    case OB2_FORMAT_Y16:
+        return cv::Mat(height, width, CV_16UC1, data, step);
+    case OB2_FORMAT_Y8:
+        return cv::Mat(height, width, CV_8UC1, data, step);
+    default:
+        return cv::Mat();
+    }
+}
+
+// ob2::image 的零拷贝视图：mat() 直接指向 SDK 的 buffer，视图存在期间持有 image 的引用
+class image_view {
+public:
+    explicit image_view(std::shared_ptr<ob2::image> im) : _image(im) {
+        if (_image == nullptr) {
+            return;
+        }
+        ob2_image_format_t format = _image->get_format();
+        // MJPG 等压缩格式没有行跨度，调用 get_stride_bytes 会抛异常
+        uint32_t stride = format == OB2_FORMAT_MJPG ? 0 : _image->get_stride_bytes();
+        _mat = wrap_image_buffer(_image->get_buffer(), _image->get_size(), format, _image->get_width_pixels(), _image->get_height_pixels(), stride);
+    }
+
+    const cv::Mat &mat() const {
+        return _mat;
+    }
+
+    const std::shared_ptr<ob2::image> &image() const {
+        return _image;
+    }
+
+    bool empty() const {
+        return _mat.empty();
+    }
+
+private:
+    std::shared_ptr<ob2::image> _image;
+    cv::Mat _mat;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "hpp/board_model.hpp"
+#include "hpp/corner_detect.hpp"
+
+// 一次 calibrateCamera 的完整输出
+struct calib_result {
+    cv::Mat cam_mat, dist;
+    std::vector<cv::Mat> rvecs, tvecs;
+    cv::Mat cam_deviation, dist_deviation;
+    std::vector<double> error;
+    double rms = 0;
+    double solve_ms = 0;
+};
+
+inline calib_result calibrate_views(const object_views &obj_points, const std::vector<std::vector<cv::Point2f> > &im_points, cv::Size im_size,
+                                    const calib_result *guess, cv::TermCriteria criteria) {
+    calib_result r;
+    int flags = 0;
+    if (guess != nullptr && !guess->cam_mat.empty()) {
+        r.cam_mat = guess->cam_mat.clone();
+        r.dist = guess->dist.clone();
+        flags |= cv::CALIB_USE_INTRINSIC_GUESS;
+    }
+    auto start = std::chrono::steady_clock::now();
+    r.rms = cv::calibrateCamera(obj_points, im_points, im_size, r.cam_mat, r.dist, r.rvecs, r.tvecs, r.cam_deviation, r.dist_deviation, r.error, flags, criteria);
+    r.solve_ms = elapsed_ms(start);
+    return r;
+}
+
+// 增量标定：每加入一个有效视图就以上一次的内参和畸变系数为初值重新求解，
+// fx、fy、cx、cy 连续 patience 次的变化都小于 tolerance 像素时视为收敛
+class incremental_calibrator {
+public:
+    incremental_calibrator(cv::Size im_size, double tolerance = 0.5, int patience = 3, int min_views = 4)
+        : _im_size(im_size), _tolerance(tolerance), _patience(patience), _min_views(min_views), _stable(0), _last_change(0) {}
+
+    // 加入一个视图，视图数达到 min_views 后返回 true 表示已完成一次求解。只保留 obj_pt 的 Mat 头，不复制数据
+    bool add_view(const cv::Mat &obj_pt, const std::vector<cv::Point2f> &im_pt) {
+        _obj_points.push_back(obj_pt);
+        _im_points.push_back(im_pt);
+        if ((int)_im_points.size() < _min_views) {
+            return false;
+        }
+        // 有初值时收敛很快，不必使用批量标定那样严格的终止条件
+        calib_result r = calibrate_views(_obj_points, _im_points, _im_size, solved() ? &_result : nullptr,
+                                         cv::TermCriteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 20, 1e-6));
+        if (solved()) {
+            _last_change = 0;
+            for (int k = 0; k < 4; ++k) {
+                _last_change = std::max(_last_change, std::abs(intrinsic(r, k) - intrinsic(_result, k)));
+            }
+            _stable = _last_change < _tolerance ? _stable + 1 : 0;
+        }
+        _result = r;
+        return true;
+    }
+
+    bool solved() const {
+        return !_result.cam_mat.empty();
+    }
+
+    bool converged() const {
+        return _stable >= _patience;
+    }
+
+    int views() const {
+        return (int)_im_points.size();
+    }
+
+    // 最近一次求解中 fx、fy、cx、cy 的最大变化，单位：像素
+    double last_change() const {
+        return _last_change;
+    }
+
+    const calib_result &result() const {
+        return _result;
+    }
+
+    const object_views &obj_points() const {
+        return _obj_points;
+    }
+
+    const std::vector<std::vector<cv::Point2f> > &im_points() const {
+        return _im_points;
+    }
+
+    // 输出一行进度：视图数、fx fy cx cy 及其标准差、本次变化量、耗时
+    void print_progress(std::ostream &out) const {
+        if (!solved()) {
+            out << "Views " << views() << ": waiting for " << _min_views << " views" << std::endl;
+            return;
+        }
+        static const char *names[] = {"fx", "fy", "cx", "cy"};
+        out << "Views " << views() << ":";
+        for (int k = 0; k < 4; ++k) {
+            out << " " << names[k] << "=" << intrinsic(_result, k) << "±" << _result.cam_deviation.at<double>(k, 0);
+        }
+        out << " change=" << _last_change << " px, rms=" << _result.rms << ", " << _result.solve_ms << " ms" << (converged() ? " [converged]" : "") << std::endl;
+    }
+
+private:
+    cv::Size _im_size;
+    double _tolerance;
+    int _patience;
+    int _min_views;
+    int _stable;
+    double _last_change;
+    calib_result _result;
+    object_views _obj_points;
+    std::vector<std::vector<cv::Point2f> > _im_points;
+
+    // 按 fx、fy、cx、cy 的顺序取内参
+    static double intrinsic(const calib_result &r, int k) {
+        static const int rows[] = {0, 1, 0, 1};
+        static const int cols[] = {0, 1, 2, 2};
+        return r.cam_mat.at<double>(rows[k], cols[k]);
+    }
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "hpp/incremental_calib.hpp"
+#include "hpp/parallel.hpp"
+
+struct rejection_options {
+    double threshold = 0.5;  // 留一误差超过该值的视图被剔除，单位：像素
+    // 只对样本内误差超过 threshold * screen 的视图做留一求解，视图多时避免对每个视图都重新标定
+    double screen = 0.5;
+    int max_rounds = 10;  // 每轮至多剔除一个视图，也即至多剔除的视图数
+    int min_views = 4;    // 至少保留的视图数，视图太少时留一求解不稳定
+    int threads = 0;      // 留一求解的线程数，0 表示使用全部核心
+};
+
+struct rejection_result {
+    std::vector<int> kept;       // 保留的视图在输入中的下标
+    std::vector<int> dropped;    // 被剔除的视图在输入中的下标，按剔除顺序
+    std::vector<double> scores;  // 与 dropped 对应的留一误差
+    int rounds = 0;
+    int solves = 0;  // 留一求解的总次数
+    double elapsed_ms = 0;
+};
+
+// 用不含该视图的标定结果估计视图位姿并计算其重投影均方根误差，即该视图的留一误差
+inline double held_out_error(const calib_result &r, const cv::Mat &obj_pt, const std::vector<cv::Point2f> &im_pt) {
+    cv::Mat rvec, tvec;
+    cv::solvePnP(obj_pt, im_pt, r.cam_mat, r.dist, rvec, tvec);
+    std::vector<cv::Point2f> projected;
+    cv::projectPoints(obj_pt, rvec, tvec, r.cam_mat, r.dist, projected);
+    double sum = 0;
+    for (size_t i = 0; i < im_pt.size(); ++i) {
+        cv::Point2f d = projected[i] - im_pt[i];
+        sum += d.dot(d);
+    }
+    return std::sqrt(sum / im_pt.size());
+}
+
+// 迭代剔除外点视图：每轮先用全部保留视图求解，再对可疑视图并行做留一求解（以全量结果为初值），
+// 只剔除留一误差最大且超过阈值的一个视图后进入下一轮（一个外点会抬高其他视图的误差，剔除它后再重新评估），
+// 直到没有视图被剔除或剩余视图数达到 min_views
+inline rejection_result reject_outlier_views(const object_views &obj_points, const std::vector<std::vector<cv::Point2f> > &im_points,
+                                             cv::Size im_size, const rejection_options &opt) {
+    auto start = std::chrono::steady_clock::now();
+    const cv::TermCriteria criteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 20, 1e-6);
+    rejection_result res;
+    for (int i = 0; i < (int)im_points.size(); ++i) {
+        res.kept.push_back(i);
+    }
+    while (res.rounds < opt.max_rounds && (int)res.kept.size() > std::max(opt.min_views, 1)) {
+        ++res.rounds;
+        object_views obj;
+        std::vector<std::vector<cv::Point2f> > im;
+        for (int i : res.kept) {
+            obj.push_back(obj_points[i]);
+            im.push_back(im_points[i]);
+        }
+        calib_result full = calibrate_views(obj, im, im_size, nullptr, criteria);
+
+        std::vector<int> candidates;
+        for (int k = 0; k < (int)res.kept.size(); ++k) {
+            if (full.error[k] > opt.threshold * opt.screen) {
+                candidates.push_back(k);
+            }
+        }
+        std::vector<double> scores(candidates.size(), 0);
+        // 视图级并行时关闭 OpenCV 内部的并行，避免线程数超额
+        const int threads = std::min(resolve_threads(opt.threads), (int)candidates.size());
+        {
+            cv_threads_guard guard(threads > 1);
+            parallel_for_index((int)candidates.size(), threads, [&](int c) {
+                int k = candidates[c];
+                object_views loo_obj;
+                std::vector<std::vector<cv::Point2f> > loo_im;
+                loo_obj.reserve(obj.size() - 1);
+                loo_im.reserve(im.size() - 1);
+                for (int j = 0; j < (int)obj.size(); ++j) {
+                    if (j != k) {
+                        loo_obj.push_back(obj[j]);
+                        loo_im.push_back(im[j]);
+                    }
+                }
+                calib_result loo = calibrate_views(loo_obj, loo_im, im_size, &full, criteria);
+                scores[c] = held_out_error(loo, obj[k], im[k]);
+            });
+        }
+        res.solves += (int)candidates.size();
+
+        int worst = -1;
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            if (scores[c] > opt.threshold && (worst < 0 || scores[c] > scores[worst])) {
+                worst = (int)c;
+            }
+        }
+        if (worst < 0) {
+            break;
+        }
+        res.dropped.push_back(res.kept[candidates[worst]]);
+        res.scores.push_back(scores[worst]);
+        res.kept.erase(res.kept.begin() + candidates[worst]);
+    }
+    res.elapsed_ms = elapsed_ms(start);
+    return res;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <opencv2/objdetect/charuco_detector.hpp>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 标出检测到的角点：完整检测时按棋盘格顺序连线，部分检测时只标出各角点及其编号
+inline void draw_board_corners(cv::Mat &im, cv::Size board_size, const std::vector<cv::Point2f> &corners, const std::vector<int> &ids) {
+    if (ids.empty()) {
+        cv::drawChessboardCorners(im, board_size, corners, true);
+    }
+    else {
+        cv::aruco::drawDetectedCornersCharuco(im, corners, ids);
+    }
+}
+
+// 在后台线程中把角点标注图写入磁盘，调用方只需提交原图路径和角点
+class overlay_writer {
+public:
+    overlay_writer(const std::string &dir, cv::Size board_size) : _dir(dir), _board_size(board_size), _stop(false), _written(0) {
+        if (!_dir.empty() && _dir.back() != '/') {
+            _dir += '/';
+        }
+        _worker = std::thread(&overlay_writer::run, this);
+    }
+
+    // 析构时写完队列中剩余的图像
+    ~overlay_writer() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cond.notify_one();
+        _worker.join();
+    }
+
+    overlay_writer(const overlay_writer &) = delete;
+    overlay_writer &operator=(const overlay_writer &) = delete;
+
+    // ids 非空时为部分检测的 ChArUco 角点，只标出检测到的角点及其编号
+    void push(const std::string &src_path, int index, const std::vector<cv::Point2f> &corners, const std::vector<int> &ids = std::vector<int>()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back({src_path, index, corners, ids});
+        }
+        _cond.notify_one();
+    }
+
+    int written() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _written;
+    }
+
+private:
+    struct job {
+        std::string src_path;
+        int index;
+        std::vector<cv::Point2f> corners;
+        std::vector<int> ids;
+    };
+
+    std::string _dir;
+    cv::Size _board_size;
+    bool _stop;
+    int _written;
+    std::deque<job> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::thread _worker;
+
+    void run() {
+        while (true) {
+            job j;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cond.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+                if (_jobs.empty()) {
+                    return;
+                }
+                j = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+            cv::Mat im = cv::imread(j.src_path);
+            if (im.empty()) {
+                std::cout << "Fail to read " << j.src_path << std::endl;
+                continue;
+            }
+            draw_board_corners(im, _board_size, j.corners, j.ids);
+            std::ostringstream buff;
+            buff << _dir << j.index << ".jpg";
+            if (!cv::imwrite(buff.str(), im)) {
+                std::cout << "Fail to write " << buff.str() << std::endl;
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_written;
+        }
+    }
+};
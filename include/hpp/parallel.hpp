@@ -0,0 +1,79 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 线程数为 0 或负数时取硬件并发数
+inline int resolve_threads(int threads) {
+    if (threads <= 0) {
+        threads = (int)std::thread::hardware_concurrency();
+    }
+    return std::max(threads, 1);
+}
+
+// 用 threads 个线程执行 fn(0) ... fn(n - 1)，各线程从同一计数器领取下标，
+// 任一线程抛出的第一个异常会在全部线程结束后重新抛出
+inline void parallel_for_index(int n, int threads, const std::function<void(int)> &fn) {
+    threads = std::min(resolve_threads(threads), n);
+    if (threads <= 1) {
+        for (int i = 0; i < n; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    std::atomic<int> next(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            int i;
+            while ((i = next++) < n) {
+                try {
+                    fn(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    next = n;
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// 外层已多线程并行时关闭 OpenCV 内部的并行，避免线程数超额；析构时恢复原来的线程数，异常退出时也会恢复
+class cv_threads_guard {
+public:
+    explicit cv_threads_guard(bool serial) : _serial(serial), _threads(cv::getNumThreads()) {
+        if (_serial) {
+            cv::setNumThreads(1);
+        }
+    }
+
+    ~cv_threads_guard() {
+        if (_serial) {
+            cv::setNumThreads(_threads);
+        }
+    }
+
+    cv_threads_guard(const cv_threads_guard &) = delete;
+    cv_threads_guard &operator=(const cv_threads_guard &) = delete;
+
+private:
+    bool _serial;
+    int _threads;
+};
@@ -0,0 +1,413 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "hpp/board_model.hpp"
+#include "hpp/corner_detect.hpp"
+#include "hpp/incremental_calib.hpp"
+#include "hpp/parallel.hpp"
+
+// 同一时刻多台相机对标定板的一次观测，每台相机至多一个。
+// 各相机的检测直接共用物方点，联合标定前须由 align_corner_orders 统一角点顺序
+struct rig_view {
+    uint64_t timestamp_usec = 0;
+    std::vector<int> cameras;
+    object_views obj_points;
+    std::vector<std::vector<cv::Point2f> > im_points;
+};
+
+// 按时间戳把各相机的有效检测匹配为同步观测：从最早的检测开始，时间戳与之相差不超过 tolerance_usec 的检测归为一组，
+// 同一相机在一组中只取最早的一个。detections[c] 为相机 c 的检测结果
+inline std::vector<rig_view> match_rig_views(const std::vector<std::vector<board_detection> > &detections, const board_model &board,
+                                             uint64_t tolerance_usec) {
+    std::vector<std::tuple<uint64_t, int, int> > items;
+    for (int c = 0; c < (int)detections.size(); ++c) {
+        for (int i = 0; i < (int)detections[c].size(); ++i) {
+            items.push_back(std::make_tuple(detections[c][i].timestamp_usec, c, i));
+        }
+    }
+    std::sort(items.begin(), items.end());
+    std::vector<rig_view> views;
+    for (size_t i = 0; i < items.size();) {
+        rig_view v;
+        v.timestamp_usec = std::get<0>(items[i]);
+        size_t j = i;
+        for (; j < items.size() && std::get<0>(items[j]) - v.timestamp_usec <= tolerance_usec; ++j) {
+            int c = std::get<1>(items[j]);
+            if (std::find(v.cameras.begin(), v.cameras.end(), c) != v.cameras.end()) {
+                continue;
+            }
+            const board_detection &det = detections[c][std::get<2>(items[j])];
+            v.cameras.push_back(c);
+            v.obj_points.push_back(board.view_points(det));
+            v.im_points.push_back(det.corners);
+        }
+        views.push_back(v);
+        i = j;
+    }
+    return views;
+}
+
+// 位姿按 rvec tvec 排列。rig_compose 返回先做 first 再做 second 的变换
+inline cv::Vec6d rig_compose(const cv::Vec6d &first, const cv::Vec6d &second) {
+    cv::Vec3d r, t;
+    cv::composeRT(cv::Vec3d(first[0], first[1], first[2]), cv::Vec3d(first[3], first[4], first[5]), cv::Vec3d(second[0], second[1], second[2]),
+                  cv::Vec3d(second[3], second[4], second[5]), r, t);
+    return cv::Vec6d(r[0], r[1], r[2], t[0], t[1], t[2]);
+}
+
+inline cv::Vec6d rig_invert(const cv::Vec6d &p) {
+    cv::Matx33d R;
+    cv::Rodrigues(cv::Vec3d(p[0], p[1], p[2]), R);
+    cv::Vec3d t = -(R.t() * cv::Vec3d(p[3], p[4], p[5]));
+    return cv::Vec6d(-p[0], -p[1], -p[2], t[0], t[1], t[2]);
+}
+
+struct rig_camera {
+    cv::Size im_size;
+    cv::Mat K, dist;
+    cv::Mat R, T;  // 相机 0 坐标系到本相机坐标系的变换：X_c = R * X_0 + T，T 的单位为 mm
+    int views = 0;
+    double rms = 0;
+};
+
+struct rig_result {
+    std::vector<rig_camera> cameras;
+    int shared_views = 0;  // 被两台及以上相机同时观测到的视图数
+    int iterations = 0;
+    double rms = 0;
+    double solve_ms = 0;
+};
+
+// 一个同步观测对法方程的贡献。全部相机的参数排成一个向量：各相机内参 fx fy cx cy k1 k2 p1 p2 k3，
+// 其后为相机 1..N-1 相对相机 0 的外参；标定板在相机 0 坐标系下的位姿为本观测独有的 6 个参数
+struct rig_block {
+    cv::Mat U, W, ga;
+    cv::Matx<double, 6, 6> V;
+    cv::Vec6d gb;
+    double sq = 0;
+    std::vector<double> cam_sq;  // 与 rig_view::cameras 对应的残差平方和
+};
+
+inline void rig_evaluate(const rig_view &view, const std::vector<std::vector<cv::Point3d> > &obj, const cv::Mat &params, int n_cam,
+                         const cv::Vec6d &board_pose, bool jac, rig_block &blk) {
+    const int P = params.rows;
+    const double *a = params.ptr<double>();
+    if (jac) {
+        blk.U = cv::Mat::zeros(P, P, CV_64F);
+        blk.W = cv::Mat::zeros(P, 6, CV_64F);
+        blk.ga = cv::Mat::zeros(P, 1, CV_64F);
+        blk.V = cv::Matx<double, 6, 6>();
+        blk.gb = cv::Vec6d();
+    }
+    blk.sq = 0;
+    blk.cam_sq.assign(view.cameras.size(), 0);
+    for (size_t k = 0; k < view.cameras.size(); ++k) {
+        const int c = view.cameras[k];
+        const double *in = a + 9 * c;
+        cv::Matx33d K(in[0], 0, in[2], 0, in[1], in[3], 0, 0, 1);
+        cv::Matx<double, 1, 5> dist(in[4], in[5], in[6], in[7], in[8]);
+        // 标定板到本相机的位姿及其对标定板位姿、相机外参的导数
+        cv::Vec3d rvec(board_pose[0], board_pose[1], board_pose[2]), tvec(board_pose[3], board_pose[4], board_pose[5]);
+        cv::Mat Mb = cv::Mat::eye(6, 6, CV_64F), Me;
+        if (c > 0) {
+            const double *e = a + 9 * n_cam + 6 * (c - 1);
+            cv::Mat dr3dr1, dr3dt1, dr3dr2, dr3dt2, dt3dr1, dt3dt1, dt3dr2, dt3dt2;
+            cv::Vec3d r3, t3;
+            cv::composeRT(rvec, tvec, cv::Vec3d(e[0], e[1], e[2]), cv::Vec3d(e[3], e[4], e[5]), r3, t3, dr3dr1, dr3dt1, dr3dr2, dr3dt2, dt3dr1,
+                          dt3dt1, dt3dr2, dt3dt2);
+            rvec = r3;
+            tvec = t3;
+            cv::Mat top, bottom;
+            cv::hconcat(dr3dr1, dr3dt1, top);
+            cv::hconcat(dt3dr1, dt3dt1, bottom);
+            cv::vconcat(top, bottom, Mb);
+            cv::hconcat(dr3dr2, dr3dt2, top);
+            cv::hconcat(dt3dr2, dt3dt2, bottom);
+            cv::vconcat(top, bottom, Me);
+        }
+        std::vector<cv::Point2d> projected;
+        cv::Mat J;
+        if (jac) {
+            // projectPoints 的雅可比按 rvec(3) tvec(3) f(2) c(2) dist(5) 排列
+            cv::projectPoints(obj[k], rvec, tvec, K, dist, projected, J);
+        }
+        else {
+            cv::projectPoints(obj[k], rvec, tvec, K, dist, projected);
+        }
+        const std::vector<cv::Point2f> &im_pt = view.im_points[k];
+        cv::Mat r((int)im_pt.size() * 2, 1, CV_64F);
+        for (size_t p = 0; p < im_pt.size(); ++p) {
+            r.at<double>((int)p * 2) = im_pt[p].x - projected[p].x;
+            r.at<double>((int)p * 2 + 1) = im_pt[p].y - projected[p].y;
+        }
+        blk.cam_sq[k] = r.dot(r);
+        blk.sq += blk.cam_sq[k];
+        if (!jac) {
+            continue;
+        }
+        // 本相机涉及的参数：9 个内参，非参考相机再加 6 个外参
+        cv::Mat Jpose = J.colRange(0, 6);
+        cv::Mat Ja = J.colRange(6, 15);
+        std::vector<int> idx;
+        for (int i = 0; i < 9; ++i) {
+            idx.push_back(9 * c + i);
+        }
+        if (c > 0) {
+            cv::Mat Je = Jpose * Me;
+            cv::hconcat(J.colRange(6, 15), Je, Ja);
+            for (int i = 0; i < 6; ++i) {
+                idx.push_back(9 * n_cam + 6 * (c - 1) + i);
+            }
+        }
+        cv::Mat Jb = Jpose * Mb;
+        cv::Mat JaJa = Ja.t() * Ja, JaJb = Ja.t() * Jb, Jar = Ja.t() * r;
+        for (int i = 0; i < (int)idx.size(); ++i) {
+            for (int j = 0; j < (int)idx.size(); ++j) {
+                blk.U.at<double>(idx[i], idx[j]) += JaJa.at<double>(i, j);
+            }
+            for (int j = 0; j < 6; ++j) {
+                blk.W.at<double>(idx[i], j) += JaJb.at<double>(i, j);
+            }
+            blk.ga.at<double>(idx[i]) += Jar.at<double>(i);
+        }
+        blk.V += cv::Matx<double, 6, 6>(cv::Mat(Jb.t() * Jb));
+        blk.gb += cv::Vec6d(cv::Mat(Jb.t() * r));
+    }
+}
+
+// 多相机联合标定：先分别标定各相机并由共同观测链式估计各相机相对相机 0 的外参，
+// 再用 Levenberg-Marquardt 联合优化全部内参、外参和各观测中标定板的位姿，标定板位姿块通过 Schur 补消去。
+// 每台相机至少需要 3 个观测，且所有相机须通过共同观测与相机 0 相连；不满足时输出原因并返回 false
+inline bool calibrate_rig(const std::vector<rig_view> &views, const std::vector<cv::Size> &im_sizes, cv::TermCriteria criteria, int threads,
+                          rig_result &res) {
+    auto start = std::chrono::steady_clock::now();
+    const int n_cam = (int)im_sizes.size();
+    const int n = (int)views.size();
+    res = rig_result();
+    res.cameras.resize(n_cam);
+
+    // 各相机单独标定，得到内参初值及每个观测中标定板到该相机的位姿
+    std::vector<object_views> mono_obj(n_cam);
+    std::vector<std::vector<std::vector<cv::Point2f> > > mono_im(n_cam);
+    std::vector<std::vector<int> > mono_index(n);
+    for (int g = 0; g < n; ++g) {
+        for (size_t k = 0; k < views[g].cameras.size(); ++k) {
+            int c = views[g].cameras[k];
+            mono_index[g].push_back((int)mono_im[c].size());
+            mono_obj[c].push_back(views[g].obj_points[k]);
+            mono_im[c].push_back(views[g].im_points[k]);
+        }
+        res.shared_views += views[g].cameras.size() > 1 ? 1 : 0;
+    }
+    for (int c = 0; c < n_cam; ++c) {
+        res.cameras[c].im_size = im_sizes[c];
+        res.cameras[c].views = (int)mono_im[c].size();
+        if (mono_im[c].size() < 3) {
+            std::cout << "Camera " << c << " has only " << mono_im[c].size() << " views, at least 3 are needed" << std::endl;
+            return false;
+        }
+    }
+    std::vector<calib_result> mono(n_cam);
+    for (int c = 0; c < n_cam; ++c) {
+        mono[c] = calibrate_views(mono_obj[c], mono_im[c], im_sizes[c], nullptr, criteria);
+    }
+    auto mono_pose = [&](int g, int k) {
+        const calib_result &m = mono[views[g].cameras[k]];
+        const cv::Mat &rv = m.rvecs[mono_index[g][k]], &tv = m.tvecs[mono_index[g][k]];
+        return cv::Vec6d(rv.at<double>(0), rv.at<double>(1), rv.at<double>(2), tv.at<double>(0), tv.at<double>(1), tv.at<double>(2));
+    };
+
+    // 外参初值：从相机 0 出发，每一轮用已知相机与未知相机的共同观测估计未知相机的外参并取平均
+    std::vector<cv::Vec6d> ext(n_cam);
+    std::vector<bool> known(n_cam, false);
+    known[0] = true;
+    for (bool grown = true; grown;) {
+        grown = false;
+        std::vector<cv::Vec6d> sum(n_cam);
+        std::vector<int> count(n_cam, 0);
+        for (int g = 0; g < n; ++g) {
+            const std::vector<int> &cams = views[g].cameras;
+            for (size_t i = 0; i < cams.size(); ++i) {
+                if (!known[cams[i]]) {
+                    continue;
+                }
+                // 标定板到相机 0 的位姿
+                cv::Vec6d board0 = rig_compose(mono_pose(g, (int)i), rig_invert(ext[cams[i]]));
+                for (size_t j = 0; j < cams.size(); ++j) {
+                    if (!known[cams[j]]) {
+                        sum[cams[j]] += rig_compose(rig_invert(board0), mono_pose(g, (int)j));
+                        ++count[cams[j]];
+                    }
+                }
+                break;
+            }
+        }
+        for (int c = 0; c < n_cam; ++c) {
+            if (count[c] > 0) {
+                ext[c] = sum[c] * (1.0 / count[c]);
+                known[c] = true;
+                grown = true;
+            }
+        }
+    }
+    for (int c = 0; c < n_cam; ++c) {
+        if (!known[c]) {
+            std::cout << "Camera " << c << " shares no view with camera 0, directly or through other cameras" << std::endl;
+            return false;
+        }
+    }
+
+    // 参数向量与标定板位姿的初值
+    const int P = 9 * n_cam + 6 * (n_cam - 1);
+    cv::Mat params(P, 1, CV_64F);
+    for (int c = 0; c < n_cam; ++c) {
+        const cv::Mat &K = mono[c].cam_mat;
+        const cv::Mat d = mono[c].dist.reshape(1, 1);
+        double in[9] = {K.at<double>(0, 0), K.at<double>(1, 1), K.at<double>(0, 2), K.at<double>(1, 2), d.at<double>(0), d.at<double>(1),
+                        d.at<double>(2), d.at<double>(3), d.at<double>(4)};
+        std::copy(in, in + 9, params.ptr<double>() + 9 * c);
+        if (c > 0) {
+            for (int i = 0; i < 6; ++i) {
+                params.at<double>(9 * n_cam + 6 * (c - 1) + i) = ext[c][i];
+            }
+        }
+    }
+    std::vector<cv::Vec6d> poses(n);
+    std::vector<std::vector<std::vector<cv::Point3d> > > obj(n);
+    int n_points = 0;
+    for (int g = 0; g < n; ++g) {
+        poses[g] = rig_compose(mono_pose(g, 0), rig_invert(ext[views[g].cameras[0]]));
+        for (size_t k = 0; k < views[g].cameras.size(); ++k) {
+            const cv::Point3f *p = views[g].obj_points[k].ptr<cv::Point3f>();
+            obj[g].push_back(std::vector<cv::Point3d>(p, p + views[g].obj_points[k].total()));
+            n_points += (int)views[g].im_points[k].size();
+        }
+    }
+
+    auto evaluate = [&](const cv::Mat &a, const std::vector<cv::Vec6d> &ps, bool jac, std::vector<rig_block> &out) {
+        parallel_for_index(n, threads, [&](int g) { rig_evaluate(views[g], obj[g], a, n_cam, ps[g], jac, out[g]); });
+        double sq = 0;
+        for (auto &blk : out) {
+            sq += blk.sq;
+        }
+        return sq;
+    };
+
+    int max_iter = (criteria.type & cv::TermCriteria::COUNT) ? criteria.maxCount : 30;
+    double eps = (criteria.type & cv::TermCriteria::EPS) ? criteria.epsilon : 1e-12;
+    double lambda = 1e-3;
+    std::vector<rig_block> blocks(n), trial(n);
+    double cost = evaluate(params, poses, true, blocks);
+    std::vector<cv::Matx<double, 6, 6> > v_inv(n);
+    std::vector<cv::Vec6d> new_poses(n);
+    for (int iter = 0; iter < max_iter; ++iter) {
+        res.iterations = iter + 1;
+        // 构造 Schur 补 S = U - Σ W V⁻¹ Wᵀ 及右端项，对角线按 λ 阻尼
+        cv::Mat S = cv::Mat::zeros(P, P, CV_64F), rhs = cv::Mat::zeros(P, 1, CV_64F);
+        for (int g = 0; g < n; ++g) {
+            S += blocks[g].U;
+            rhs += blocks[g].ga;
+        }
+        for (int k = 0; k < P; ++k) {
+            S.at<double>(k, k) *= 1 + lambda;
+        }
+        for (int g = 0; g < n; ++g) {
+            cv::Matx<double, 6, 6> V = blocks[g].V;
+            for (int k = 0; k < 6; ++k) {
+                V(k, k) *= 1 + lambda;
+            }
+            v_inv[g] = V.inv(cv::DECOMP_CHOLESKY);
+            cv::Mat WV = blocks[g].W * cv::Mat(v_inv[g]);
+            S -= WV * blocks[g].W.t();
+            rhs -= WV * cv::Mat(blocks[g].gb);
+        }
+        cv::Mat da;
+        if (!cv::solve(S, rhs, da, cv::DECOMP_CHOLESKY)) {
+            lambda *= 10;
+            if (lambda > 1e10) {
+                break;
+            }
+            continue;
+        }
+        cv::Mat new_params = params + da;
+        double step = cv::norm(da);
+        for (int g = 0; g < n; ++g) {
+            cv::Vec6d db = v_inv[g] * (blocks[g].gb - cv::Vec6d(cv::Mat(blocks[g].W.t() * da)));
+            new_poses[g] = poses[g] + db;
+            step = std::max(step, cv::norm(db));
+        }
+
+        double new_cost = evaluate(new_params, new_poses, true, trial);
+        if (new_cost < cost) {
+            double decrease = (cost - new_cost) / cost;
+            params = new_params;
+            poses.swap(new_poses);
+            blocks.swap(trial);
+            cost = new_cost;
+            lambda = std::max(lambda * 0.1, 1e-12);
+            if (decrease < eps || step < eps) {
+                break;
+            }
+        }
+        else {
+            lambda *= 10;
+            if (lambda > 1e10) {
+                break;
+            }
+        }
+    }
+
+    std::vector<double> cam_sq(n_cam, 0);
+    std::vector<int> cam_points(n_cam, 0);
+    for (int g = 0; g < n; ++g) {
+        for (size_t k = 0; k < views[g].cameras.size(); ++k) {
+            cam_sq[views[g].cameras[k]] += blocks[g].cam_sq[k];
+            cam_points[views[g].cameras[k]] += (int)views[g].im_points[k].size();
+        }
+    }
+    const double *a = params.ptr<double>();
+    for (int c = 0; c < n_cam; ++c) {
+        rig_camera &cam = res.cameras[c];
+        const double *in = a + 9 * c;
+        cam.K = (cv::Mat_<double>(3, 3) << in[0], 0, in[2], 0, in[1], in[3], 0, 0, 1);
+        cam.dist = (cv::Mat_<double>(1, 5) << in[4], in[5], in[6], in[7], in[8]);
+        cv::Vec6d e = c > 0 ? cv::Vec6d(a + 9 * n_cam + 6 * (c - 1)) : cv::Vec6d();
+        cv::Rodrigues(cv::Vec3d(e[0], e[1], e[2]), cam.R);
+        cam.T = (cv::Mat_<double>(3, 1) << e[3], e[4], e[5]) * 1000.0;
+        cam.rms = std::sqrt(cam_sq[c] / std::max(1, cam_points[c]));
+    }
+    res.rms = std::sqrt(cost / std::max(1, n_points));
+    res.solve_ms = elapsed_ms(start);
+    return true;
+}
+
+// names[c] 为相机 c 的序列号或录制文件名
+inline bool save_rig_params(const std::string &path, const rig_result &res, const std::vector<std::string> &names) {
+    cv::FileStorage fs(path, cv::FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        std::cout << "Fail to open " << path << std::endl;
+        return false;
+    }
+    fs << "camera_count" << (int)res.cameras.size() << "rms" << res.rms;
+    for (size_t c = 0; c < res.cameras.size(); ++c) {
+        const rig_camera &cam = res.cameras[c];
+        std::ostringstream key;
+        key << "camera_" << c;
+        fs << key.str() << "{";
+        fs << "name" << (c < names.size() ? names[c] : std::string());
+        fs << "width" << cam.im_size.width << "height" << cam.im_size.height;
+        fs << "camera_matrix" << cam.K << "dist_coeffs" << cam.dist;
+        fs << "rotation" << cam.R << "translation_mm" << cam.T << "rms" << cam.rms;
+        fs << "}";
+    }
+    return true;
+}
@@ -0,0 +1,214 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "hpp/incremental_calib.hpp"
+#include "hpp/parallel.hpp"
+
+// 单个视图对法方程的贡献。内参按 fx fy cx cy k1 k2 p1 p2 k3 排列，位姿按 rvec tvec 排列
+struct schur_block {
+    cv::Matx<double, 9, 9> U;
+    cv::Matx<double, 9, 6> W;
+    cv::Matx<double, 6, 6> V;
+    cv::Vec<double, 9> ga;
+    cv::Vec<double, 6> gb;
+    double sq = 0;  // 残差平方和
+};
+
+// 计算一个视图的残差平方和，jac 为 true 时同时累加 JᵀJ 和 Jᵀr 的各个分块
+inline void schur_evaluate(const std::vector<cv::Point3d> &obj_pt, const std::vector<cv::Point2f> &im_pt, const cv::Vec<double, 9> &intr,
+                           const cv::Vec6d &pose, bool jac, schur_block &blk) {
+    cv::Matx33d K(intr[0], 0, intr[2], 0, intr[1], intr[3], 0, 0, 1);
+    cv::Matx<double, 1, 5> dist(intr[4], intr[5], intr[6], intr[7], intr[8]);
+    cv::Vec3d rvec(pose[0], pose[1], pose[2]), tvec(pose[3], pose[4], pose[5]);
+    std::vector<cv::Point2d> projected;
+    cv::Mat J;
+    if (jac) {
+        // projectPoints 的雅可比按 rvec(3) tvec(3) f(2) c(2) dist(5) 排列
+        cv::projectPoints(obj_pt, rvec, tvec, K, dist, projected, J);
+    }
+    else {
+        cv::projectPoints(obj_pt, rvec, tvec, K, dist, projected);
+    }
+    blk = schur_block();
+    for (size_t p = 0; p < im_pt.size(); ++p) {
+        double r[2] = {im_pt[p].x - projected[p].x, im_pt[p].y - projected[p].y};
+        blk.sq += r[0] * r[0] + r[1] * r[1];
+        if (!jac) {
+            continue;
+        }
+        for (int d = 0; d < 2; ++d) {
+            const double *row = J.ptr<double>((int)p * 2 + d);
+            const double *a = row + 6;
+            const double *b = row;
+            for (int i = 0; i < 9; ++i) {
+                blk.ga[i] += a[i] * r[d];
+                for (int j = i; j < 9; ++j) {
+                    blk.U(i, j) += a[i] * a[j];
+                }
+                for (int j = 0; j < 6; ++j) {
+                    blk.W(i, j) += a[i] * b[j];
+                }
+            }
+            for (int i = 0; i < 6; ++i) {
+                blk.gb[i] += b[i] * r[d];
+                for (int j = i; j < 6; ++j) {
+                    blk.V(i, j) += b[i] * b[j];
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 9; ++i) {
+        for (int j = 0; j < i; ++j) {
+            blk.U(i, j) = blk.U(j, i);
+        }
+    }
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < i; ++j) {
+            blk.V(i, j) = blk.V(j, i);
+        }
+    }
+}
+
+// 利用块稀疏结构的 Levenberg-Marquardt 标定：每个视图的 6 自由度位姿块通过 Schur 补消去，
+// 每次迭代只需求解 9x9 的内参方程，代价随视图数线性增长；各视图的雅可比在多个线程中计算。
+// 输出与 calibrateCamera 相同：内参、畸变系数、内参和外参标准差、每个视图的重投影误差
+inline calib_result calibrate_views_schur(const object_views &obj_points, const std::vector<std::vector<cv::Point2f> > &im_points,
+                                          cv::Size im_size, const calib_result *guess, cv::TermCriteria criteria, int threads = 0) {
+    auto start = std::chrono::steady_clock::now();
+    const int n = (int)im_points.size();
+    calib_result r;
+    if (n == 0) {
+        return r;
+    }
+
+    std::vector<std::vector<cv::Point3d> > obj(n);
+    int n_points = 0;
+    for (int i = 0; i < n; ++i) {
+        const cv::Point3f *p = obj_points[i].ptr<cv::Point3f>();
+        obj[i].assign(p, p + obj_points[i].total());
+        n_points += (int)im_points[i].size();
+    }
+
+    cv::Mat K0, dist0 = cv::Mat::zeros(1, 5, CV_64F);
+    if (guess != nullptr && !guess->cam_mat.empty()) {
+        K0 = guess->cam_mat.clone();
+        guess->dist.reshape(1, 1).colRange(0, 5).copyTo(dist0);
+    }
+    else {
+        K0 = cv::initCameraMatrix2D(obj_points, im_points, im_size);
+    }
+    cv::Vec<double, 9> intr(K0.at<double>(0, 0), K0.at<double>(1, 1), K0.at<double>(0, 2), K0.at<double>(1, 2), dist0.at<double>(0), dist0.at<double>(1),
+                            dist0.at<double>(2), dist0.at<double>(3), dist0.at<double>(4));
+    std::vector<cv::Vec6d> poses(n);
+    parallel_for_index(n, threads, [&](int i) {
+        cv::Vec3d rvec, tvec;
+        cv::solvePnP(obj_points[i], im_points[i], K0, dist0, rvec, tvec);
+        poses[i] = cv::Vec6d(rvec[0], rvec[1], rvec[2], tvec[0], tvec[1], tvec[2]);
+    });
+
+    std::vector<schur_block> blocks(n);
+    auto evaluate = [&](const cv::Vec<double, 9> &in, const std::vector<cv::Vec6d> &ps, bool jac, std::vector<schur_block> &out) {
+        parallel_for_index(n, threads, [&](int i) { schur_evaluate(obj[i], im_points[i], in, ps[i], jac, out[i]); });
+        double sq = 0;
+        for (auto &blk : out) {
+            sq += blk.sq;
+        }
+        return sq;
+    };
+
+    int max_iter = (criteria.type & cv::TermCriteria::COUNT) ? criteria.maxCount : 30;
+    double eps = (criteria.type & cv::TermCriteria::EPS) ? criteria.epsilon : 1e-12;
+    double lambda = 1e-3;
+    double cost = evaluate(intr, poses, true, blocks);
+    std::vector<schur_block> trial(n);
+    std::vector<cv::Matx<double, 6, 6> > v_inv(n);
+    std::vector<cv::Vec6d> new_poses(n);
+    for (int iter = 0; iter < max_iter; ++iter) {
+        // 构造 Schur 补 S = U - Σ W V⁻¹ Wᵀ 及右端项，对角线按 λ 阻尼
+        cv::Matx<double, 9, 9> S;
+        cv::Vec<double, 9> rhs;
+        for (int i = 0; i < n; ++i) {
+            S += blocks[i].U;
+            rhs += blocks[i].ga;
+        }
+        for (int k = 0; k < 9; ++k) {
+            S(k, k) *= 1 + lambda;
+        }
+        for (int i = 0; i < n; ++i) {
+            cv::Matx<double, 6, 6> V = blocks[i].V;
+            for (int k = 0; k < 6; ++k) {
+                V(k, k) *= 1 + lambda;
+            }
+            v_inv[i] = V.inv(cv::DECOMP_CHOLESKY);
+            cv::Matx<double, 9, 6> WV = blocks[i].W * v_inv[i];
+            S -= WV * blocks[i].W.t();
+            rhs -= WV * blocks[i].gb;
+        }
+        cv::Vec<double, 9> da = S.solve(rhs, cv::DECOMP_CHOLESKY);
+        cv::Vec<double, 9> new_intr = intr + da;
+        double step = cv::norm(da);
+        for (int i = 0; i < n; ++i) {
+            cv::Vec6d db = v_inv[i] * (blocks[i].gb - blocks[i].W.t() * da);
+            new_poses[i] = poses[i] + db;
+            step = std::max(step, cv::norm(db));
+        }
+
+        double new_cost = evaluate(new_intr, new_poses, true, trial);
+        if (new_cost < cost) {
+            double decrease = (cost - new_cost) / cost;
+            intr = new_intr;
+            poses.swap(new_poses);
+            blocks.swap(trial);
+            cost = new_cost;
+            lambda = std::max(lambda * 0.1, 1e-12);
+            if (decrease < eps || step < eps) {
+                break;
+            }
+        }
+        else {
+            lambda *= 10;
+            if (lambda > 1e10) {
+                break;
+            }
+        }
+    }
+
+    // 不加阻尼的 Schur 补的逆即为内参的协方差块
+    cv::Matx<double, 9, 9> S;
+    for (int i = 0; i < n; ++i) {
+        S += blocks[i].U;
+    }
+    for (int i = 0; i < n; ++i) {
+        v_inv[i] = blocks[i].V.inv(cv::DECOMP_CHOLESKY);
+        S -= blocks[i].W * v_inv[i] * blocks[i].W.t();
+    }
+    cv::Matx<double, 9, 9> S_inv = S.inv(cv::DECOMP_SVD);
+    int dof = std::max(1, n_points * 2 - 9 - 6 * n);
+    double sigma2 = cost / dof;
+
+    r.cam_mat = (cv::Mat_<double>(3, 3) << intr[0], 0, intr[2], 0, intr[1], intr[3], 0, 0, 1);
+    r.dist = (cv::Mat_<double>(1, 5) << intr[4], intr[5], intr[6], intr[7], intr[8]);
+    // 与 calibrateCamera 一致：内参标准差为 18x1，本求解器不估计的参数为 0
+    r.cam_deviation = cv::Mat::zeros(18, 1, CV_64F);
+    for (int k = 0; k < 9; ++k) {
+        r.cam_deviation.at<double>(k) = std::sqrt(std::max(0.0, S_inv(k, k) * sigma2));
+    }
+    r.dist_deviation = cv::Mat::zeros(6 * n, 1, CV_64F);
+    for (int i = 0; i < n; ++i) {
+        // 位姿的边缘协方差 V⁻¹ + V⁻¹ Wᵀ S⁻¹ W V⁻¹
+        cv::Matx<double, 9, 6> WV = blocks[i].W * v_inv[i];
+        cv::Matx<double, 6, 6> cov = v_inv[i] + WV.t() * S_inv * WV;
+        for (int k = 0; k < 6; ++k) {
+            r.dist_deviation.at<double>(6 * i + k) = std::sqrt(std::max(0.0, cov(k, k) * sigma2));
+        }
+        r.rvecs.push_back((cv::Mat_<double>(3, 1) << poses[i][0], poses[i][1], poses[i][2]));
+        r.tvecs.push_back((cv::Mat_<double>(3, 1) << poses[i][3], poses[i][4], poses[i][5]));
+        r.error.push_back(std::sqrt(blocks[i].sq / im_points[i].size()));
+    }
+    r.rms = std::sqrt(cost / n_points);
+    r.solve_ms = elapsed_ms(start);
+    return r;
+}
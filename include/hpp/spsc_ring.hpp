@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// 无锁单生产者单消费者环形队列：只允许一个线程 try_push、一个线程 try_pop，满时 try_push 直接返回 false
+template <typename T> class spsc_ring {
+public:
+    explicit spsc_ring(size_t capacity) : _slots(capacity + 1), _head(0), _tail(0) {}
+
+    spsc_ring(const spsc_ring &) = delete;
+    spsc_ring &operator=(const spsc_ring &) = delete;
+
+    bool try_push(T item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) % _slots.size();
+        if (next == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        _slots[tail] = std::move(item);
+        _tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(_slots[head]);
+        // 及时释放槽位中的对象，避免环形队列延长帧的生命周期
+        _slots[head] = T();
+        _head.store((head + 1) % _slots.size(), std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> _slots;
+    // 生产者与消费者各自写的下标放在不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+};
@@ -0,0 +1,139 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hpp/corner_detect.hpp"
+#include "hpp/incremental_calib.hpp"
+
+// IR 相机与彩色相机的参数。R、T 把 IR 相机坐标系下的点变换到彩色相机坐标系：X_color = R * X_ir + T，T 的单位为 mm
+struct stereo_params {
+    cv::Mat ir_K, ir_dist;
+    cv::Mat color_K, color_dist;
+    cv::Size ir_size, color_size;
+    cv::Mat R, T;
+};
+
+// 按 grasp --stereo 的命名规则列出 dir/N_color.jpg 与 dir/N_ir.png，遇到第一对不完整的序号即停止
+inline void list_stereo_pairs(const std::string &dir, std::vector<std::string> &color_paths, std::vector<std::string> &ir_paths) {
+    for (int count = 0;; ++count) {
+        std::stringstream color, ir;
+        color << dir << count << "_color.jpg";
+        ir << dir << count << "_ir.png";
+        if (!std::ifstream(color.str()).good() || !std::ifstream(ir.str()).good()) {
+            break;
+        }
+        color_paths.push_back(color.str());
+        ir_paths.push_back(ir.str());
+    }
+}
+
+inline bool save_stereo_params(const std::string &path, const stereo_params &p) {
+    cv::FileStorage fs(path, cv::FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        std::cout << "Fail to open " << path << std::endl;
+        return false;
+    }
+    fs << "ir_width" << p.ir_size.width << "ir_height" << p.ir_size.height;
+    fs << "ir_camera_matrix" << p.ir_K << "ir_dist_coeffs" << p.ir_dist;
+    fs << "color_width" << p.color_size.width << "color_height" << p.color_size.height;
+    fs << "color_camera_matrix" << p.color_K << "color_dist_coeffs" << p.color_dist;
+    fs << "rotation" << p.R << "translation_mm" << p.T;
+    return true;
+}
+
+inline bool load_stereo_params(const std::string &path, stereo_params &p) {
+    cv::FileStorage fs(path, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cout << "Fail to open " << path << std::endl;
+        return false;
+    }
+    p.ir_size = cv::Size((int)fs["ir_width"], (int)fs["ir_height"]);
+    fs["ir_camera_matrix"] >> p.ir_K;
+    fs["ir_dist_coeffs"] >> p.ir_dist;
+    p.color_size = cv::Size((int)fs["color_width"], (int)fs["color_height"]);
+    fs["color_camera_matrix"] >> p.color_K;
+    fs["color_dist_coeffs"] >> p.color_dist;
+    fs["rotation"] >> p.R;
+    fs["translation_mm"] >> p.T;
+    return true;
+}
+
+// 把内参矩阵换算到另一分辨率，例如出厂参数与采集时的分辨率不同
+inline cv::Mat scale_camera_matrix(const cv::Mat &K, cv::Size from, cv::Size to) {
+    cv::Mat scaled = K.clone();
+    if (from.area() > 0 && to.area() > 0 && from != to) {
+        cv::Mat x = scaled.row(0), y = scaled.row(1);
+        x *= (double)to.width / from.width;
+        y *= (double)to.height / from.height;
+    }
+    return scaled;
+}
+
+struct stereo_result {
+    stereo_params params;
+    double rms = 0;
+    double ir_rms = 0;
+    double color_rms = 0;
+    std::vector<double> error;  // 每对视图的重投影误差，两列分别为 IR 与彩色
+    double solve_ms = 0;
+};
+
+// 先分别标定 IR 与彩色相机，再以此为初值用 stereoCalibrate 联合优化两者的内参及 IR 到彩色的旋转平移。
+// obj_points 的单位为 m，输出的平移换算为 mm 以便与出厂参数对比
+inline stereo_result calibrate_stereo(const object_views &obj_points, const std::vector<std::vector<cv::Point2f> > &ir_points,
+                                      const std::vector<std::vector<cv::Point2f> > &color_points, cv::Size ir_size, cv::Size color_size) {
+    auto start = std::chrono::steady_clock::now();
+    const cv::TermCriteria criteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 50, 1e-12);
+    stereo_result res;
+    calib_result ir = calibrate_views(obj_points, ir_points, ir_size, nullptr, criteria);
+    calib_result color = calibrate_views(obj_points, color_points, color_size, nullptr, criteria);
+    res.ir_rms = ir.rms;
+    res.color_rms = color.rms;
+
+    stereo_params &p = res.params;
+    p.ir_K = ir.cam_mat;
+    p.ir_dist = ir.dist;
+    p.color_K = color.cam_mat;
+    p.color_dist = color.dist;
+    p.ir_size = ir_size;
+    p.color_size = color_size;
+    cv::Mat E, F, per_view;
+    // 两个相机分辨率不同，imageSize 只在不使用初值时用于初始化内参，这里不起作用
+    res.rms = cv::stereoCalibrate(obj_points, ir_points, color_points, p.ir_K, p.ir_dist, p.color_K, p.color_dist, ir_size, p.R, p.T, E, F, per_view,
+                                  cv::CALIB_USE_INTRINSIC_GUESS, criteria);
+    p.T *= 1000.0;
+    res.error.assign((double *)per_view.datastart, (double *)per_view.dataend);
+    res.solve_ms = elapsed_ms(start);
+    return res;
+}
+
+// 与出厂参数对比：旋转差异的角度、平移差异、内参差异（出厂内参按分辨率换算后）
+inline void print_stereo_drift(std::ostream &out, const stereo_params &measured, const stereo_params &factory) {
+    cv::Mat dR = measured.R * factory.R.t();
+    cv::Mat rvec;
+    cv::Rodrigues(dR, rvec);
+    const double deg = 180.0 / CV_PI;
+    out << "Rotation drift = " << cv::norm(rvec) * deg << " deg" << std::endl;
+    out << "Translation (mm): measured " << measured.T.t() << ", factory " << factory.T.t() << ", drift " << cv::norm(measured.T - factory.T) << " mm"
+        << std::endl;
+    static const char *names[] = {"fx", "fy", "cx", "cy"};
+    static const int rows[] = {0, 1, 0, 1};
+    static const int cols[] = {0, 1, 2, 2};
+    cv::Mat ir_K = scale_camera_matrix(factory.ir_K, factory.ir_size, measured.ir_size);
+    cv::Mat color_K = scale_camera_matrix(factory.color_K, factory.color_size, measured.color_size);
+    out << "IR intrinsics drift (px):";
+    for (int k = 0; k < 4; ++k) {
+        out << " " << names[k] << " " << measured.ir_K.at<double>(rows[k], cols[k]) - ir_K.at<double>(rows[k], cols[k]);
+    }
+    out << "\nColor intrinsics drift (px):";
+    for (int k = 0; k < 4; ++k) {
+        out << " " << names[k] << " " << measured.color_K.at<double>(rows[k], cols[k]) - color_K.at<double>(rows[k], cols[k]);
+    }
+    out << std::endl;
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "hpp/board_model.hpp"
+#include "hpp/parallel.hpp"
+
+// 合成棋盘格视图的参数。K、dist 为真值内参和畸变系数，渲染出的角点与 chessboard_points 的顺序一致
+struct synthetic_options {
+    cv::Size board_size = cv::Size(11, 8);  // 内角点的列数和行数
+    float side = 0.025f;                    // 格子边长，单位：m
+    cv::Size im_size = cv::Size(1920, 1080);
+    cv::Mat K, dist;
+    double min_distance = 0.4;  // 标定板中心到相机的距离范围，单位：m
+    double max_distance = 1.0;
+    double max_tilt = 0.6;      // 标定板绕 x、y 轴倾斜的上限，单位：rad
+    double blur = 0;            // 高斯模糊的标准差，单位：像素，0 表示不模糊
+    double noise = 2;           // 灰度噪声的标准差
+    int supersample = 2;        // 每个像素在两个方向上的采样数，用于抗锯齿
+    int threads = 0;            // 渲染线程数，0 表示使用全部核心
+};
+
+struct synthetic_view {
+    cv::Mat image;                     // CV_8UC1
+    cv::Vec3d rvec, tvec;              // 标定板坐标系到相机坐标系的真值位姿
+    std::vector<cv::Point2f> corners;  // 角点的真值像素坐标
+};
+
+// 按真值内参和畸变系数渲染棋盘格视图。构造时计算一次各采样点去畸变后的归一化坐标，
+// 每个视图只需把这些坐标经单应变换映射到标定板纹理上再 remap，不必逐视图求解畸变模型
+class synthetic_renderer {
+public:
+    explicit synthetic_renderer(const synthetic_options &opt) : _opt(opt), _obj_pt(chessboard_points(opt.board_size, opt.side)) {
+        _opt.supersample = std::max(1, _opt.supersample);
+        build_texture();
+        build_rays();
+    }
+
+    // 随机生成整块标定板（含白边）都在画面内的位姿并渲染
+    synthetic_view render(cv::RNG &rng) const {
+        const int w = _opt.board_size.width, h = _opt.board_size.height;
+        const double s = _opt.side;
+        // 标定板坐标系中 x 沿行方向、y 沿列方向，白边外缘距第一个内角点两个格子
+        std::vector<cv::Point3f> outline = {cv::Point3f(-2 * s, -2 * s, 0), cv::Point3f((h + 1) * s, -2 * s, 0), cv::Point3f(-2 * s, (w + 1) * s, 0),
+                                            cv::Point3f((h + 1) * s, (w + 1) * s, 0)};
+        cv::Vec3d center(s * (h - 1) / 2, s * (w - 1) / 2, 0);
+        synthetic_view view;
+        while (true) {
+            view.rvec = cv::Vec3d(rng.uniform(-_opt.max_tilt, _opt.max_tilt), rng.uniform(-_opt.max_tilt, _opt.max_tilt), rng.uniform(-CV_PI, CV_PI));
+            cv::Matx33d R;
+            cv::Rodrigues(view.rvec, R);
+            double z = rng.uniform(_opt.min_distance, _opt.max_distance);
+            // 中心在画面内随机偏移，偏移量随距离增大
+            double x = rng.uniform(-0.5, 0.5) * z * _opt.im_size.width / _opt.K.at<double>(0, 0);
+            double y = rng.uniform(-0.5, 0.5) * z * _opt.im_size.height / _opt.K.at<double>(1, 1);
+            view.tvec = cv::Vec3d(x, y, z) - R * center;
+            std::vector<cv::Point2f> im_outline;
+            cv::projectPoints(outline, view.rvec, view.tvec, _opt.K, _opt.dist, im_outline);
+            bool inside = true;
+            for (auto &p : im_outline) {
+                inside = inside && p.x >= 0 && p.y >= 0 && p.x < _opt.im_size.width && p.y < _opt.im_size.height;
+            }
+            if (inside) {
+                break;
+            }
+        }
+        view.image = render(view.rvec, view.tvec, rng);
+        cv::projectPoints(_obj_pt, view.rvec, view.tvec, _opt.K, _opt.dist, view.corners);
+        return view;
+    }
+
+    // 渲染给定位姿下的视图，rng 只用于生成噪声
+    cv::Mat render(const cv::Vec3d &rvec, const cv::Vec3d &tvec, cv::RNG &rng) const {
+        cv::Matx33d R;
+        cv::Rodrigues(rvec, R);
+        // H 把标定板平面上的 (x, y, 1) 映射到归一化相机坐标，A 把标定板坐标换算为纹理像素坐标（像素中心为整数）
+        cv::Matx33d H(R(0, 0), R(0, 1), tvec[0], R(1, 0), R(1, 1), tvec[1], R(2, 0), R(2, 1), tvec[2]);
+        const double scale = _texel / _opt.side, offset = 2 * _texel - 0.5;
+        cv::Matx33d A(0, scale, offset, scale, 0, offset, 0, 0, 1);
+        cv::Matx33d M = A * H.inv();
+        cv::Mat map_x(_rays.size(), CV_32FC1), map_y(_rays.size(), CV_32FC1);
+        parallel_for_index(_rays.rows, _opt.threads, [&](int r) {
+            const cv::Point2f *ray = _rays.ptr<cv::Point2f>(r);
+            float *mx = map_x.ptr<float>(r), *my = map_y.ptr<float>(r);
+            for (int c = 0; c < _rays.cols; ++c) {
+                double u = M(0, 0) * ray[c].x + M(0, 1) * ray[c].y + M(0, 2);
+                double v = M(1, 0) * ray[c].x + M(1, 1) * ray[c].y + M(1, 2);
+                double w = M(2, 0) * ray[c].x + M(2, 1) * ray[c].y + M(2, 2);
+                // w 为交点深度的倒数，不大于 0 时射线与标定板平面交于相机后方
+                if (w > 1e-12) {
+                    mx[c] = (float)(u / w);
+                    my[c] = (float)(v / w);
+                }
+                else {
+                    mx[c] = my[c] = -1e6f;
+                }
+            }
+        });
+        cv::Mat fine, image;
+        cv::remap(_texture, fine, map_x, map_y, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(background));
+        if (_opt.supersample > 1) {
+            cv::resize(fine, image, _opt.im_size, 0, 0, cv::INTER_AREA);
+        }
+        else {
+            image = fine;
+        }
+        if (_opt.blur > 0) {
+            cv::GaussianBlur(image, image, cv::Size(), _opt.blur);
+        }
+        if (_opt.noise > 0) {
+            cv::Mat noise(image.size(), CV_16SC1);
+            rng.fill(noise, cv::RNG::NORMAL, 0, _opt.noise);
+            cv::add(image, noise, image, cv::noArray(), CV_8U);
+        }
+        return image;
+    }
+
+    const synthetic_options &options() const {
+        return _opt;
+    }
+
+private:
+    static const int background = 110;
+    synthetic_options _opt;
+    std::vector<cv::Point3f> _obj_pt;
+    cv::Mat _texture;  // 含一格白边的棋盘格纹理
+    cv::Mat _rays;     // 各采样点去畸变后的归一化坐标，CV_32FC2
+    int _texel = 128;  // 纹理中每个格子的像素数
+
+    void build_texture() {
+        // 内角点 (cols, rows) 个，格子 (cols + 1, rows + 1) 个，四周各留一格白边
+        const int cols = _opt.board_size.width + 3, rows = _opt.board_size.height + 3;
+        _texture.create(rows * _texel, cols * _texel, CV_8UC1);
+        _texture.setTo(cv::Scalar(220));
+        for (int r = 1; r < rows - 1; ++r) {
+            for (int c = 1; c < cols - 1; ++c) {
+                if ((r + c) % 2 == 0) {
+                    _texture(cv::Rect(c * _texel, r * _texel, _texel, _texel)).setTo(cv::Scalar(30));
+                }
+            }
+        }
+    }
+
+    // 超采样图像的像素 (x, y) 对应原图坐标 ((x + 0.5) / ss - 0.5, (y + 0.5) / ss - 0.5)，按 ss 缩小后像素中心与原图一致
+    void build_rays() {
+        const int ss = _opt.supersample;
+        cv::Size fine(_opt.im_size.width * ss, _opt.im_size.height * ss);
+        cv::Mat pixels(fine, CV_32FC2);
+        for (int y = 0; y < fine.height; ++y) {
+            cv::Point2f *p = pixels.ptr<cv::Point2f>(y);
+            for (int x = 0; x < fine.width; ++x) {
+                p[x] = cv::Point2f((x + 0.5f) / ss - 0.5f, (y + 0.5f) / ss - 0.5f);
+            }
+        }
+        // 畸变较大时默认的 5 次迭代不够精确
+        cv::undistortPoints(pixels.reshape(2, 1), _rays, _opt.K, _opt.dist, cv::noArray(), cv::noArray(),
+                            cv::TermCriteria(cv::TermCriteria::Type::COUNT + cv::TermCriteria::Type::EPS, 50, 1e-9));
+        _rays = _rays.reshape(2, fine.height);
+    }
+};
@@ -0,0 +1,256 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "hpp/corner_cache.hpp"
+#include "hpp/stereo_calib.hpp"
+
+// 只读映射整个文件；不支持 mmap 的平台退化为一次性读入内存
+class mapped_file {
+public:
+    mapped_file() : _data(nullptr), _size(0) {}
+
+    ~mapped_file() {
+        close();
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    bool open(const std::string &path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                _data = (const uchar *)p;
+                _size = st.st_size;
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary);
+        _buffer.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!_buffer.empty()) {
+            _data = _buffer.data();
+            _size = _buffer.size();
+        }
+#endif
+        return _data != nullptr;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (_data != nullptr) {
+            munmap((void *)_data, _size);
+        }
+#else
+        _buffer.clear();
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    const uchar *data() const {
+        return _data;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    const uchar *_data;
+    size_t _size;
+#ifdef _WIN32
+    std::vector<uchar> _buffer;
+#endif
+};
+
+// 读取 calibrate 输出的内参文件
+inline bool load_intrinsics(const std::string &path, cv::Mat &K, cv::Mat &dist, cv::Size &im_size) {
+    cv::FileStorage fs(path, cv::FileStorage::READ);
+    if (!fs.isOpened()) {
+        std::cout << "Fail to open " << path << std::endl;
+        return false;
+    }
+    fs["camera_matrix"] >> K;
+    fs["dist_coeffs"] >> dist;
+    im_size = cv::Size((int)fs["width"], (int)fs["height"]);
+    return !K.empty();
+}
+
+inline bool save_intrinsics(const std::string &path, const cv::Mat &K, const cv::Mat &dist, cv::Size im_size) {
+    cv::FileStorage fs(path, cv::FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        std::cout << "Fail to open " << path << std::endl;
+        return false;
+    }
+    fs << "width" << im_size.width << "height" << im_size.height << "camera_matrix" << K << "dist_coeffs" << dist;
+    return true;
+}
+
+// 去畸变映射表。每个 (内参, 畸变系数, 分辨率, alpha) 只构建一次，以 OpenCV 的定点格式保存：
+// map1 为 CV_16SC2 的整数源坐标，map2 为 CV_16UC1 的插值系数表下标，每像素 6 字节，约为浮点映射表的四分之三，
+// remap 时按整数查表插值。映射表写入缓存文件，下次启动时直接映射该文件，不再计算
+class undistort_map {
+public:
+    undistort_map() : _key(0), _from_cache(false), _build_ms(0) {}
+
+    undistort_map(const undistort_map &) = delete;
+    undistort_map &operator=(const undistort_map &) = delete;
+
+    // 准备 size 分辨率下的映射表。K 为 calib_size 分辨率下的内参，分辨率不同时按比例换算；
+    // alpha 与 getOptimalNewCameraMatrix 相同，0 只保留有效像素，1 保留全部原始像素。cache_path 为空时不使用缓存
+    bool prepare(const cv::Mat &K, const cv::Mat &dist, cv::Size calib_size, cv::Size size, double alpha, const std::string &cache_path) {
+        cv::Mat K64, dist64;
+        scale_camera_matrix(K, calib_size, size).convertTo(K64, CV_64F);
+        dist.convertTo(dist64, CV_64F);
+        uint64_t key = map_key(K64, dist64, size, alpha);
+        if (!_map1.empty() && key == _key) {
+            return true;
+        }
+        // 旧的映射表可能指向即将解除映射的缓存文件，先释放再重建
+        _map1.release();
+        _map2.release();
+        _file.close();
+        _key = key;
+        _from_cache = !cache_path.empty() && load(cache_path, key, size);
+        if (_from_cache) {
+            return true;
+        }
+        auto start = std::chrono::steady_clock::now();
+        _new_K = cv::getOptimalNewCameraMatrix(K64, dist64, size, alpha, size);
+        cv::initUndistortRectifyMap(K64, dist64, cv::Mat(), _new_K, size, CV_16SC2, _map1, _map2);
+        _build_ms = elapsed_ms(start);
+        if (!cache_path.empty()) {
+            save(cache_path);
+        }
+        return !_map1.empty();
+    }
+
+    // remap 内部按行分块多线程执行；src 的分辨率须与 prepare 时一致
+    void apply(const cv::Mat &src, cv::Mat &dst) const {
+        cv::remap(src, dst, _map1, _map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+    }
+
+    bool ready() const {
+        return !_map1.empty();
+    }
+
+    cv::Size size() const {
+        return _map1.size();
+    }
+
+    // 去畸变后图像的内参
+    const cv::Mat &new_camera_matrix() const {
+        return _new_K;
+    }
+
+    // 最近一次 prepare 是否直接使用了缓存文件
+    bool from_cache() const {
+        return _from_cache;
+    }
+
+    // 最近一次构建映射表的耗时，使用缓存时不更新
+    double build_ms() const {
+        return _build_ms;
+    }
+
+private:
+    // 缓存文件头，其后依次为 map1 与 map2 的数据
+    struct file_header {
+        char magic[8];
+        uint64_t key;
+        int32_t width, height;
+        double new_K[9];
+    };
+
+    uint64_t _key;
+    bool _from_cache;
+    double _build_ms;
+    cv::Mat _map1, _map2, _new_K;
+    mapped_file _file;
+
+    static uint64_t map_key(const cv::Mat &K, const cv::Mat &dist, cv::Size size, double alpha) {
+        cv::Mat d = dist.reshape(1, 1);
+        uint64_t h = content_hash(K.ptr<uchar>(), K.total() * K.elemSize());
+        h = content_hash(d.ptr<uchar>(), d.total() * d.elemSize(), h);
+        int32_t fields[] = {size.width, size.height};
+        h = content_hash((const uchar *)fields, sizeof(fields), h);
+        return content_hash((const uchar *)&alpha, sizeof(alpha), h);
+    }
+
+    static size_t map_bytes(cv::Size size) {
+        return (size_t)size.area() * (4 + 2);
+    }
+
+    // 键或尺寸不符时返回 false。映射表直接指向映射的文件内容，不复制
+    bool load(const std::string &path, uint64_t key, cv::Size size) {
+        if (!_file.open(path) || _file.size() != sizeof(file_header) + map_bytes(size)) {
+            _file.close();
+            return false;
+        }
+        file_header h;
+        std::memcpy(&h, _file.data(), sizeof(h));
+        if (std::memcmp(h.magic, "OBUNDIST", 8) != 0 || h.key != key || h.width != size.width || h.height != size.height) {
+            _file.close();
+            return false;
+        }
+        uchar *p = const_cast<uchar *>(_file.data()) + sizeof(file_header);
+        _map1 = cv::Mat(size, CV_16SC2, p);
+        _map2 = cv::Mat(size, CV_16UC1, p + (size_t)size.area() * 4);
+        _new_K = cv::Mat(3, 3, CV_64F, h.new_K).clone();
+        return true;
+    }
+
+    // 先写临时文件再改名，其它进程不会读到写了一半的缓存
+    void save(const std::string &path) const {
+        file_header h;
+        std::memcpy(h.magic, "OBUNDIST", 8);
+        h.key = _key;
+        h.width = _map1.cols;
+        h.height = _map1.rows;
+        std::memcpy(h.new_K, _new_K.ptr<double>(), sizeof(h.new_K));
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            out.write((const char *)&h, sizeof(h));
+            for (const cv::Mat *m : {&_map1, &_map2}) {
+                for (int r = 0; r < m->rows; ++r) {
+                    out.write((const char *)m->ptr(r), m->cols * m->elemSize());
+                }
+            }
+            if (!out) {
+                std::cout << "Fail to write " << tmp << std::endl;
+                return;
+            }
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::cout << "Fail to write " << path << std::endl;
+            std::remove(tmp.c_str());
+        }
+    }
+};
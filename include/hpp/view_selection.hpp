@@ -0,0 +1,112 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "hpp/parallel.hpp"
+#include "hpp/schur_calib.hpp"
+
+struct selection_options {
+    int budget = 20;  // 最多选取的视图数
+    // 覆盖项的权重：每覆盖一个新的图像网格单元，得分增加 coverage_weight / 单元总数
+    double coverage_weight = 2.0;
+    cv::Size grid = cv::Size(8, 6);  // 统计图像覆盖的网格
+    int threads = 0;
+};
+
+struct selection_result {
+    std::vector<int> selected;  // 按选取顺序排列的视图下标
+    double coverage = 0;        // 选中视图覆盖的网格单元比例
+    double elapsed_ms = 0;
+};
+
+// 贪心选取视图子集：以粗略内参下各视图消去位姿后的内参信息矩阵 U - W V⁻¹ Wᵀ 为依据，
+// 每次加入使 log det(累计信息) 增加最多的视图（D 最优），并奖励覆盖新图像区域的视图，
+// 位姿相近的视图信息方向重复，增益自然较小
+inline selection_result select_views(const object_views &obj_points, const std::vector<std::vector<cv::Point2f> > &im_points,
+                                     cv::Size im_size, const selection_options &opt) {
+    auto start = std::chrono::steady_clock::now();
+    const int n = (int)im_points.size();
+    selection_result res;
+    if (n == 0) {
+        return res;
+    }
+
+    // 粗略内参：initCameraMatrix2D 加零畸变，位姿由 solvePnP 得到
+    cv::Mat K = cv::initCameraMatrix2D(obj_points, im_points, im_size);
+    cv::Mat dist = cv::Mat::zeros(1, 5, CV_64F);
+    cv::Vec<double, 9> intr(K.at<double>(0, 0), K.at<double>(1, 1), K.at<double>(0, 2), K.at<double>(1, 2), 0, 0, 0, 0, 0);
+    std::vector<cv::Matx<double, 9, 9> > info(n);
+    const int cells = opt.grid.area();
+    std::vector<std::vector<int> > covered(n);
+    parallel_for_index(n, opt.threads, [&](int i) {
+        cv::Vec3d rvec, tvec;
+        cv::solvePnP(obj_points[i], im_points[i], K, dist, rvec, tvec);
+        const cv::Point3f *p = obj_points[i].ptr<cv::Point3f>();
+        std::vector<cv::Point3d> obj(p, p + obj_points[i].total());
+        schur_block blk;
+        schur_evaluate(obj, im_points[i], intr, cv::Vec6d(rvec[0], rvec[1], rvec[2], tvec[0], tvec[1], tvec[2]), true, blk);
+        info[i] = blk.U - blk.W * blk.V.inv(cv::DECOMP_CHOLESKY) * blk.W.t();
+        std::vector<char> hit(cells, 0);
+        for (auto &p : im_points[i]) {
+            int cx = std::min(opt.grid.width - 1, std::max(0, (int)(p.x * opt.grid.width / im_size.width)));
+            int cy = std::min(opt.grid.height - 1, std::max(0, (int)(p.y * opt.grid.height / im_size.height)));
+            if (!hit[cy * opt.grid.width + cx]) {
+                hit[cy * opt.grid.width + cx] = 1;
+                covered[i].push_back(cy * opt.grid.width + cx);
+            }
+        }
+    });
+
+    // 各参数量纲差别很大，按全部视图信息的对角线归一化后再加一个很小的正则项，保证行列式有定义
+    cv::Matx<double, 9, 9> total;
+    for (auto &m : info) {
+        total += m;
+    }
+    cv::Matx<double, 9, 9> scale;
+    for (int k = 0; k < 9; ++k) {
+        scale(k, k) = 1.0 / std::sqrt(std::max(total(k, k), 1e-300));
+    }
+    for (auto &m : info) {
+        m = scale * m * scale;
+    }
+    cv::Matx<double, 9, 9> acc = cv::Matx<double, 9, 9>::eye() * (1e-6 / n);
+
+    std::vector<char> used(n, 0), cell_used(cells, 0);
+    int cells_covered = 0;
+    double log_det = std::log(cv::determinant(acc));
+    while ((int)res.selected.size() < std::min(opt.budget, n)) {
+        int best = -1;
+        double best_score = -1e300, best_log_det = 0;
+        for (int i = 0; i < n; ++i) {
+            if (used[i]) {
+                continue;
+            }
+            double d = cv::determinant(acc + info[i]);
+            double ld = d > 0 ? std::log(d) : log_det;
+            int fresh = 0;
+            for (int c : covered[i]) {
+                fresh += !cell_used[c];
+            }
+            double score = (ld - log_det) + opt.coverage_weight * fresh / cells;
+            if (score > best_score) {
+                best_score = score;
+                best = i;
+                best_log_det = ld;
+            }
+        }
+        used[best] = 1;
+        acc += info[best];
+        log_det = best_log_det;
+        for (int c : covered[best]) {
+            cells_covered += !cell_used[c];
+            cell_used[c] = 1;
+        }
+        res.selected.push_back(best);
+    }
+    res.coverage = (double)cells_covered / cells;
+    res.elapsed_ms = elapsed_ms(start);
+    return res;
+}
@@ -6,24 +6,12 @@
 extern "C" {
 #include "hpp/OB2Camera.hpp"
 }
+#include "hpp/blend.hpp"
+#include "hpp/depth_colormap.hpp"
+#include "hpp/frame_pool.hpp"
+#include "hpp/image_view.hpp"
 #define ESC 27
 
-// 快速取平方根的倒数
-float Q_rsqrt(float number) {
-    long        i;
-    float       x2, y;
-    const float threehalfs = 1.5F;
-
-    x2 = number * 0.5F;
-    y  = number;
-    i  = *(long *)&y;
-    i  = 0x5f3759df - (i >> 1);
-    y  = *(float *)&i;
-    y  = y * (threehalfs - (x2 * y * y));
-
-    return y;
-}
-
 typedef enum {
     RENDER_SINGLE,      // Render only the first frame in the array
     RENDER_ONE_ROW,     // Render the frames in the array as a single line
@@ -34,7 +22,8 @@ typedef enum {
 
 class Window {
 public:
-    Window(std::string name, int width, int height) : _name(name), _width(width), _height(height), _windowClose(false), _key(-1) {}
+    Window(std::string name, int width, int height)
+        : _name(name), _width(width), _height(height), _windowClose(false), _key(-1), _layoutCount(0), _layoutType(RENDER_SINGLE) {}
 
     ~Window() {}
 
@@ -43,6 +32,11 @@ public:
         _height = height;
     }
 
+    // Depth values outside [nearMm, farMm] are clamped to the ends of the color map
+    void setDepthRange(float nearMm, float farMm) {
+        _colormap.set_range(nearMm, farMm);
+    }
+
     void render(std::vector<std::shared_ptr<ob2::image>> images, RenderType renderType) {
         _key = cv::waitKey(10);
         if(_key == ESC) {
@@ -85,98 +79,90 @@ private:
     int         _height;
     bool        _windowClose;
     int         _key;
+    frame_pool     _pool;
+    depth_colormap _colormap;
+
+    // Tile layout of the persistent canvas used by RENDER_ONE_ROW, RENDER_ONE_COLUMN and RENDER_GRID
+    cv::Mat              _canvas;
+    std::vector<cv::Rect> _tiles;
+    int                  _layoutCount;
+    RenderType           _layoutType;
+    cv::Size             _layoutSize;
 
     std::vector<cv::Mat> processImages(std::vector<std::shared_ptr<ob2::image>> images) {
         std::vector<cv::Mat> mats;
-        void *               data;
-        uint32_t             dataSize;
         ob2_camera_type_t    cameraType;
         ob2_image_format_t   format;
-        uint32_t             width;
-        uint32_t             height;
+        cv::Size             size;
 
         for(auto im: images) {
             if(im == nullptr || im->get_size() < 1024) {
                 break;
             }
 
-            data       = im->get_buffer();
-            dataSize   = im->get_size();
+            // Convert straight from the SDK buffer, without copying it first
+            image_view view(im);
             cameraType = im->get_source_camera_type();
             format     = im->get_format();
-            width      = im->get_width_pixels();
-            height     = im->get_height_pixels();
+            size       = cv::Size(im->get_width_pixels(), im->get_height_pixels());
 
-            cv::Mat rstMat;
+            // Output buffers come from the pool, so steady-state streaming does not allocate frames
+            cv::Mat rstMat = _pool.acquire(size, CV_8UC3);
             switch(cameraType) {
             case OB2_CAMERA_COLOR:
                 switch(format) {
                 case OB2_FORMAT_MJPG:
-                    rstMat = cv::Mat(1, dataSize, CV_8UC1, data).clone();
-                    rstMat = cv::imdecode(rstMat, 1);
+                    cv::imdecode(view.mat(), 1, &rstMat);
                     break;
                 case OB2_FORMAT_YUYV:
-                    rstMat = cv::Mat(height, width, CV_8UC2, data).clone();
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_YUV2BGR_YUYV);
+                    cv::cvtColor(view.mat(), rstMat, cv::COLOR_YUV2BGR_YUYV);
                     break;
                 case OB2_FORMAT_NV12:
-                    rstMat = cv::Mat(height, width, CV_8UC3, data).clone();
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_YUV2BGR_NV12);
+                    cv::cvtColor(view.mat(), rstMat, cv::COLOR_YUV2BGR_NV12);
                     break;
                 case OB2_FORMAT_RGB:
-                    rstMat = cv::Mat(height, width, CV_8UC3, data).clone();
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_RGB2BGR);
+                    cv::cvtColor(view.mat(), rstMat, cv::COLOR_RGB2BGR);
                     break;
                 default:
+                    rstMat.release();
                     break;
                 }
                 break;
             case OB2_CAMERA_DEPTH:
                 switch(format) {
-                case OB2_FORMAT_Y16: {
-                    float scale = im->get_value_scale();
-                    rstMat      = cv::Mat(height, width, CV_16UC1, data).clone();
-                    // cv::threshold(rstMat, rstMat, 6000 / scale, 0, cv::THRESH_TRUNC);
-
-                    // Scaling of depth values from 0 to 6000mm to 0 to 255
-                    rstMat = rstMat * 255 / (6000 / scale);
-
-                    // CV_16UC1 to CV_8UC1, which includes the cv::threshold operation, i.e. any value greater than 255 becomes 255
-                    rstMat.convertTo(rstMat, CV_8UC1);
-
-                    cv::applyColorMap(rstMat, rstMat, cv::COLORMAP_JET);
-                } break;
+                case OB2_FORMAT_Y16:
+                    // Depth values from 0 to 6000mm straight to JET colors in a single pass
+                    _colormap.apply(view.mat(), im->get_value_scale(), rstMat);
+                    break;
                 default:
+                    rstMat.release();
                     break;
                 }
                 break;
             case OB2_CAMERA_IR:
                 switch(format) {
-                case OB2_FORMAT_Y16:
-                    rstMat = cv::Mat(height, width, CV_16UC1, data).clone();
+                case OB2_FORMAT_Y16: {
+                    cv::Mat grayMat = _pool.acquire(size, CV_8UC1);
                     // cv::threshold(rstMat, rstMat, 4096, 0, cv::THRESH_TRUNC);
 
-                    // Most of the value of ir pixels are between 0 and 20102448, scaling them to 0 to 255
-                    rstMat = rstMat * 255 / 1024;
+                    // Most of the value of ir pixels are between 0 and 20102448, scaling them to 0 to 255, any value greater than 255 becomes 255
+                    view.mat().convertTo(grayMat, CV_8UC1, 255.0 / 1024);
 
-                    // CV_16UC1 to CV_8UC1, which includes the cv::threshold operation, i.e. any value greater than 255 becomes 255
-                    rstMat.convertTo(rstMat, CV_8UC1);
-
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_GRAY2BGR);
-                    break;
+                    cv::cvtColor(grayMat, rstMat, cv::COLOR_GRAY2BGR);
+                } break;
                 case OB2_FORMAT_Y8:
-                    rstMat = cv::Mat(height, width, CV_8UC1, data).clone();
-                    cv::cvtColor(rstMat, rstMat, cv::COLOR_GRAY2BGR);
+                    cv::cvtColor(view.mat(), rstMat, cv::COLOR_GRAY2BGR);
                     break;
                 case OB2_FORMAT_MJPG:
-                    rstMat = cv::Mat(1, dataSize, CV_8UC1, data).clone();
-                    rstMat = cv::imdecode(rstMat, 1);
+                    cv::imdecode(view.mat(), 1, &rstMat);
                     break;
                 default:
+                    rstMat.release();
                     break;
                 }
                 break;
             default:
+                rstMat.release();
                 break;
             }
 
@@ -187,6 +173,40 @@ private:
         return mats;
     }
 
+    // Recompute the tiles and reallocate the canvas only when the stream count, layout, image type or window size changes
+    void updateLayout(int count, RenderType renderType, int type) {
+        cv::Size size(_width, _height);
+        if(count == _layoutCount && renderType == _layoutType && size == _layoutSize && type == _canvas.type()) {
+            return;
+        }
+        int cols = 1;
+        int rows = 1;
+        if(renderType == RENDER_ONE_ROW) {
+            cols = count;
+        }
+        else if(renderType == RENDER_ONE_COLUMN) {
+            rows = count;
+        }
+        else {
+            // The smallest square grid that holds all streams, dropping empty rows
+            while(cols * cols < count) {
+                cols++;
+            }
+            rows = (count + cols - 1) / cols;
+        }
+        int tileWidth  = _width / cols;
+        int tileHeight = _height / rows;
+        _tiles.clear();
+        for(int i = 0; i < count; i++) {
+            _tiles.push_back(cv::Rect((i % cols) * tileWidth, (i / cols) * tileHeight, tileWidth, tileHeight));
+        }
+        // Unused grid cells stay black
+        _canvas      = cv::Mat::zeros(rows * tileHeight, cols * tileWidth, type);
+        _layoutCount = count;
+        _layoutType  = renderType;
+        _layoutSize  = size;
+    }
+
     void renderMats(std::vector<cv::Mat> mats, RenderType renderType) {
         if(mats.size() == 0) {
             return;
@@ -197,72 +217,14 @@ private:
                 cv::resize(mats[0], outMat, cv::Size(_width, _height));
                 cv::imshow(_name, outMat);
             }
-            else if(renderType == RENDER_ONE_ROW) {
-                cv::Mat outMat;
-                for(auto mat: mats) {
-                    cv::Mat resizeMat;
-                    cv::resize(mat, resizeMat, cv::Size(_width / mats.size(), _height));
-                    if(outMat.dims > 0) {
-                        cv::hconcat(outMat, resizeMat, outMat);
-                    }
-                    else {
-                        outMat = resizeMat;
-                    }
+            else if(renderType == RENDER_ONE_ROW || renderType == RENDER_ONE_COLUMN || renderType == RENDER_GRID) {
+                // Resize every stream straight into its tile, no concatenation copies
+                updateLayout((int)mats.size(), renderType, mats[0].type());
+                for(size_t i = 0; i < mats.size(); i++) {
+                    cv::Mat tile = _canvas(_tiles[i]);
+                    cv::resize(mats[i], tile, _tiles[i].size());
                 }
-                cv::imshow(_name, outMat);
-            }
-            else if(renderType == RENDER_ONE_COLUMN) {
-                cv::Mat outMat;
-                for(auto mat: mats) {
-                    cv::Mat resizeMat;
-                    cv::resize(mat, resizeMat, cv::Size(_width, _height / mats.size()));
-                    if(outMat.dims > 0) {
-                        cv::vconcat(outMat, resizeMat, outMat);
-                    }
-                    else {
-                        outMat = resizeMat;
-                    }
-                }
-                cv::imshow(_name, outMat);
-            }
-            else if(renderType == RENDER_GRID) {
-                int     count = mats.size();
-                float   sq    = 1.0f / Q_rsqrt((float)count);
-                int     isq   = (int)sq;
-                int     cols  = (sq - isq < 0.01f) ? isq : isq + 1;
-                float   div   = (float)count / (float)cols;
-                int     idiv  = (int)div;
-                int     rows  = (div - idiv < 0.01f) ? idiv : idiv + 1;
-                cv::Mat outMat;
-                for(int i = 0; i < rows; i++) {
-                    cv::Mat lineMat;
-                    for(int j = 0; j < cols; j++) {
-                        cv::Mat mat;
-                        cv::Mat resizeMat;
-                        int     index = i * cols + j;
-                        if(index < count) {
-                            mat = mats[index];
-                        }
-                        else {
-                            mat = cv::Mat(_width / cols, _height / rows, CV_8UC3);
-                        }
-                        cv::resize(mat, resizeMat, cv::Size(_width / cols, _height / rows));
-
-                        if(lineMat.dims > 0) {
-                            cv::hconcat(lineMat, resizeMat, lineMat);
-                        }
-                        else {
-                            lineMat = resizeMat;
-                        }
-                    }
-                    if(outMat.dims > 0) {
-                        cv::vconcat(outMat, lineMat, outMat);
-                    }
-                    else {
-                        outMat = lineMat;
-                    }
-                }
-                cv::imshow(_name, outMat);
+                cv::imshow(_name, _canvas);
             }
             else if(renderType == RENDER_OVERLAY) {
                 cv::Mat outMat, resizeMat;
@@ -290,16 +252,8 @@ private:
             cv::resize(mats[0], outMat, cv::Size(_width, _height));
             cv::resize(mats[1], resizeMat, cv::Size(_width, _height));
 
-            for(int i = 0; i < outMat.rows; i++) {
-                for(int j = 0; j < outMat.cols; j++) {
-                    cv::Vec3b &outRgb    = outMat.at<cv::Vec3b>(i, j);
-                    cv::Vec3b &resizeRgb = resizeMat.at<cv::Vec3b>(i, j);
-
-                    outRgb[0] = (uint8_t)(outRgb[0] * (1 - alpha) + resizeRgb[0] * alpha);
-                    outRgb[1] = (uint8_t)(outRgb[1] * (1 - alpha) + resizeRgb[1] * alpha);
-                    outRgb[2] = (uint8_t)(outRgb[2] * (1 - alpha) + resizeRgb[2] * alpha);
-                }
-            }
+            // Blend in place
+            blend(outMat, resizeMat, alpha, outMat);
             cv::imshow(_name, outMat);
         }
         catch(std::exception &e) {
@@ -0,0 +1,278 @@
+#pragma once
+// OrbbecSDK2 的软件替身：实现 include/h 中声明的 C 接口，不需要相机和厂商库。
+// 图像由程序合成，或从目录中的 JPEG 文件按 MJPG 格式循环输出；录制与回放使用替身自己的文件格式。
+// 参数来自 ob2_create_context_with_config 指定的配置文件（每行 KEY=VALUE）和同名环境变量，环境变量优先：
+//   OB2SIM_DEVICES    设备数，默认 1
+//   OB2SIM_COLOR      彩色流，形如 1920x1080@30:YUYV，格式支持 YUYV、NV12、RGB、BGR、Y8、MJPG
+//   OB2SIM_DEPTH      深度流，默认 640x576@30:Y16
+//   OB2SIM_IR         IR 流，默认 640x576@30:Y16，格式支持 Y16、Y8
+//   OB2SIM_COLOR_DIR  非空时彩色流依次输出该目录中的 0.jpg, 1.jpg ...（MJPG 格式，分辨率取自文件）
+//   OB2SIM_REALTIME   1 按帧率和录制时间戳定时输出，0 不等待、尽快输出，用于压力测试
+// IMU 按配置的采样率输出静止状态的数据：加速度 (0, -1, 0) g，角速度为 0
+
+extern "C" {
+#include "h/ob2camera.h"
+#include "h/ob2command.h"
+#include "h/ob2context.h"
+#include "h/ob2device.h"
+#include "h/ob2imu.h"
+#include "h/ob2playback.h"
+#include "h/ob2record.h"
+}
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ob2sim {
+
+// 接口内部以异常报告错误，由 OB2SIM_TRY / OB2SIM_CATCH 转换为 ob2_status_t
+struct logic_error : std::logic_error {
+    using std::logic_error::logic_error;
+};
+
+inline void set_status(ob2_status_t *status, ob2_status_code_t code, const char *function, const char *message) {
+    if (status == nullptr) {
+        return;
+    }
+    std::memset(status, 0, sizeof(*status));
+    status->code = code;
+    if (code != OB2_STATUS_OK) {
+        std::snprintf(status->message, sizeof(status->message), "%s", message);
+        std::snprintf(status->function, sizeof(status->function), "%s", function);
+    }
+}
+
+#define OB2SIM_TRY(status)                                   \
+    ob2sim::set_status(status, OB2_STATUS_OK, "", "");       \
+    try {
+#define OB2SIM_CATCH(status, result)                                                 \
+    }                                                                                \
+    catch (const ob2sim::logic_error &e) {                                           \
+        ob2sim::set_status(status, OB2_STATUS_LOGIC_ERROR, __func__, e.what());      \
+    }                                                                                \
+    catch (const std::exception &e) {                                                \
+        ob2sim::set_status(status, OB2_STATUS_RUNTIME_ERROR, __func__, e.what());    \
+    }                                                                                \
+    catch (...) {                                                                    \
+        ob2sim::set_status(status, OB2_STATUS_UNKNOWN_ERROR, __func__, "unknown");   \
+    }                                                                                \
+    return result;
+
+template <typename T> T *check_handle(T *handle, const char *name) {
+    if (handle == nullptr) {
+        throw logic_error(std::string("NULL handle passed for argument \"") + name + "\"");
+    }
+    return handle;
+}
+
+inline uint64_t steady_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t system_usec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 深度、彩色、IR 以 ob2_camera_type_t 为下标
+const int camera_slots = 4;
+
+struct sim_config {
+    int devices = 1;
+    ob2_camera_stream_profile_t profiles[camera_slots] = {{0, 0, 0, OB2_FORMAT_UNKNOWN},
+                                                         {1920, 1080, 30, OB2_FORMAT_YUYV},
+                                                         {640, 576, 30, OB2_FORMAT_Y16},
+                                                         {640, 576, 30, OB2_FORMAT_Y16}};
+    std::string color_dir;
+    bool realtime = true;
+};
+
+// 读取配置文件和环境变量，格式错误时抛出 logic_error
+sim_config load_config(const char *config_file_path);
+std::string format_name(ob2_image_format_t format);
+ob2_image_format_t parse_format(const std::string &name);
+// 每行字节数，MJPG 等压缩格式返回 0
+uint32_t default_stride(ob2_image_format_t format, uint32_t width);
+// 不含压缩格式的图像数据字节数
+uint32_t image_bytes(ob2_image_format_t format, uint32_t stride, uint32_t height);
+// 从 JPEG 的 SOF 段读取分辨率
+bool jpeg_size(const std::vector<uint8_t> &data, uint32_t &width, uint32_t &height);
+// 相机内参按分辨率给出：水平视场约 70°，光心在图像中心，无畸变
+ob2_cameras_calibration_t default_calibration(const ob2_camera_stream_profile_t &color, const ob2_camera_stream_profile_t &depth);
+
+}  // namespace ob2sim
+
+struct OB2ImageImpl {
+    std::atomic<int> refs{1};
+    ob2_camera_type_t camera = OB2_CAMERA_UNKNOWN;
+    ob2_image_format_t format = OB2_FORMAT_UNKNOWN;
+    uint32_t width = 0, height = 0, stride = 0;
+    uint8_t *buffer = nullptr;
+    uint32_t size = 0;
+    std::vector<uint8_t> storage;  // 由替身分配时的数据，外部缓冲区时为空
+    ob2_buffer_release_cb_t release_cb = nullptr;
+    void *release_user_data = nullptr;
+    uint64_t device_timestamp_usec = 0;
+    uint64_t system_timestamp_usec = 0;
+    uint8_t bits = 8;
+    float value_scale = 1.0f;
+
+    ~OB2ImageImpl() {
+        if (release_cb != nullptr) {
+            release_cb(buffer, release_user_data);
+        }
+    }
+};
+
+struct OB2CaptureImpl {
+    std::atomic<int> refs{1};
+    ob2_image_t images[ob2sim::camera_slots] = {nullptr, nullptr, nullptr, nullptr};
+
+    ~OB2CaptureImpl() {
+        for (ob2_image_t im : images) {
+            if (im != nullptr) {
+                ob2_image_release(im, nullptr);
+            }
+        }
+    }
+};
+
+struct OB2CamerasConfigImpl {
+    bool enabled[ob2sim::camera_slots] = {false, false, false, false};
+    ob2_camera_stream_profile_t profiles[ob2sim::camera_slots];
+    ob2_images_sync_mode_t sync_mode = OB2_IMAGES_SYNC_MODE_WAIT_LATER_COMER;
+    ob2_produce_capture_policy_t policy = OB2_PRODUCE_CAPTURE_SYNC_IMAGES_ONLY;
+    ob2_images_align_mode_t align_mode = OB2_IMAGES_ALIGN_MODE_DISABLE;
+};
+
+struct OB2ImuConfigImpl {
+    bool accel = true, gyro = true;
+    ob2_accel_stream_profile_t accel_profile = {OB2_SAMPLE_RATE_200_HZ, OB2_ACCEL_FS_4_G};
+    ob2_gyro_stream_profile_t gyro_profile = {OB2_SAMPLE_RATE_200_HZ, OB2_GYRO_FS_1000_DPS};
+};
+
+struct OB2ImuSampleImpl {
+    std::atomic<int> refs{1};
+    std::vector<ob2_accel_sample_t> accel;
+    std::vector<ob2_gyro_sample_t> gyro;
+};
+
+// 一条数据流：持有按帧序号生成或读取图像的方法
+struct sim_stream {
+    ob2_camera_type_t camera = OB2_CAMERA_UNKNOWN;
+    ob2_camera_stream_profile_t profile;
+    std::vector<uint8_t> base;                 // 合成图像的静态背景，每帧复制后再画上移动的竖条
+    std::vector<std::vector<uint8_t> > files;  // 来自目录的 JPEG 文件
+
+    ob2_image_t make_image(uint64_t frame, uint64_t device_usec, uint64_t system_usec) const;
+};
+
+struct OB2DeviceImpl {
+    uint32_t index = 0;
+    ob2_device_installation_info_t installation;
+    std::shared_ptr<const ob2sim::sim_config> config;
+    std::atomic<uint64_t> clock_offset_usec{0};  // 设备时间戳为 steady_usec() 加上该偏移，各设备互不相同
+
+    // 相机流
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<ob2_capture_t> captures;  // 未设置回调时供 ob2_device_get_capture 读取，满时丢弃最旧的
+    std::thread camera_thread;
+    std::atomic<bool> cameras_running{false};
+    std::atomic<uint64_t> camera_generation{0};  // 每次启动加一，在回调中停止后又重新启动时旧线程据此退出
+    ob2_capture_cb_t capture_cb = nullptr;
+    void *capture_user_data = nullptr;
+    OB2CamerasConfigImpl active;
+
+    // IMU
+    std::thread imu_thread;
+    std::atomic<bool> imu_running{false};
+    std::atomic<uint64_t> imu_generation{0};
+    std::deque<ob2_imu_sample_t> imu_samples;
+    ob2_imu_sample_cb_t imu_cb = nullptr;
+    void *imu_user_data = nullptr;
+
+    // 保护 camera_thread、imu_thread 和 retired_threads；后者为在自己的回调中停止的线程，关闭设备时等待其结束
+    std::mutex thread_mutex;
+    std::vector<std::thread> retired_threads;
+
+    // 属性
+    std::mutex property_mutex;
+    std::map<int, float> properties;
+
+    ~OB2DeviceImpl();
+};
+
+struct OB2ContextImpl {
+    std::shared_ptr<const ob2sim::sim_config> config;
+    std::vector<ob2_device_installation_info_t> devices;
+};
+
+namespace ob2sim {
+// 停止相机流并清空未取走的 capture，设备关闭时也会调用
+void stop_cameras(OB2DeviceImpl *dev);
+void stop_imu(OB2DeviceImpl *dev);
+
+// 停止工作线程：在该线程自己的回调中停止时不能等待自己，线程移入 retired（不分离），
+// 由之后在其他线程中的 stop、start 或关闭等待其结束。worker 本身也由 mutex 保护，启动线程时须持有 mutex 赋值
+inline void retire_or_join(std::thread &worker, std::mutex &mutex, std::vector<std::thread> &retired) {
+    std::thread t;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!worker.joinable()) {
+            return;
+        }
+        if (worker.get_id() == std::this_thread::get_id()) {
+            retired.push_back(std::move(worker));
+            return;
+        }
+        t = std::move(worker);
+    }
+    t.join();
+}
+
+// 等待 retired 中的线程结束，当前线程自身除外；返回是否仍有线程未结束（即当前线程在其中）
+inline bool join_retired(std::mutex &mutex, std::vector<std::thread> &retired) {
+    std::vector<std::thread> threads, self;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.swap(retired);
+    }
+    for (std::thread &t : threads) {
+        if (t.get_id() == std::this_thread::get_id()) {
+            self.push_back(std::move(t));
+        }
+        else {
+            t.join();
+        }
+    }
+    if (self.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::thread &t : self) {
+        retired.push_back(std::move(t));
+    }
+    return true;
+}
+
+// 关闭时仍有线程无法等待（在自己的回调中关闭），只能分离，此后该线程不能再访问已释放的对象
+inline void abandon_retired(std::mutex &mutex, std::vector<std::thread> &retired, const char *what) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::thread &t : retired) {
+        std::fprintf(stderr, "ob2sim: %s closed from its own callback\n", what);
+        t.detach();
+    }
+    retired.clear();
+}
+}  // namespace ob2sim
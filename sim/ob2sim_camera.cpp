@@ -0,0 +1,737 @@
+#include "ob2sim.hpp"
+
+#include <algorithm>
+
+namespace ob2sim {
+
+// 未设置回调时缓存的 capture 数，超出后丢弃最旧的，与 SDK 内部队列溢出时的行为一致
+const size_t max_queued_captures = 4;
+
+uint32_t default_stride(ob2_image_format_t format, uint32_t width) {
+    switch (format) {
+    case OB2_FORMAT_YUYV:
+    case OB2_FORMAT_Y16:
+        return width * 2;
+    case OB2_FORMAT_RGB:
+    case OB2_FORMAT_BGR:
+        return width * 3;
+    case OB2_FORMAT_NV12:
+    case OB2_FORMAT_Y8:
+        return width;
+    default:
+        return 0;
+    }
+}
+
+uint32_t image_bytes(ob2_image_format_t format, uint32_t stride, uint32_t height) {
+    // NV12 在 Y 平面之后是半高的 UV 平面
+    return format == OB2_FORMAT_NV12 ? stride * height * 3 / 2 : stride * height;
+}
+
+bool jpeg_size(const std::vector<uint8_t> &data, uint32_t &width, uint32_t &height) {
+    if (data.size() < 4 || data[0] != 0xff || data[1] != 0xd8) {
+        return false;
+    }
+    size_t i = 2;
+    while (i + 9 < data.size()) {
+        if (data[i] != 0xff) {
+            return false;
+        }
+        uint8_t marker = data[i + 1];
+        if (marker == 0xff) {
+            ++i;
+            continue;
+        }
+        // SOF0 ~ SOF15，其中 0xc4、0xc8、0xcc 不是帧头
+        if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+            height = (data[i + 5] << 8) | data[i + 6];
+            width = (data[i + 7] << 8) | data[i + 8];
+            return width > 0 && height > 0;
+        }
+        i += 2 + ((data[i + 2] << 8) | data[i + 3]);
+    }
+    return false;
+}
+
+// 合成图像中移动竖条的像素值，竖条每帧右移 8 像素，便于在画面上确认帧在更新
+static void draw_bar(uint8_t *row, ob2_camera_type_t camera, ob2_image_format_t format, uint32_t x) {
+    switch (format) {
+    case OB2_FORMAT_YUYV:
+        row[2 * x] = 235;
+        break;
+    case OB2_FORMAT_RGB:
+    case OB2_FORMAT_BGR:
+        row[3 * x] = row[3 * x + 1] = row[3 * x + 2] = 255;
+        break;
+    case OB2_FORMAT_Y16:
+        // 深度单位为 mm，IR 为 10 位灰度
+        ((uint16_t *)row)[x] = camera == OB2_CAMERA_DEPTH ? 500 : 1000;
+        break;
+    default:
+        row[x] = camera == OB2_CAMERA_COLOR ? 235 : 250;
+        break;
+    }
+}
+
+// 静态背景：彩色和 IR 为水平灰度渐变，深度为由上到下从 0.8 m 到 2 m 的斜面
+static std::vector<uint8_t> make_base(ob2_camera_type_t camera, const ob2_camera_stream_profile_t &p) {
+    const uint32_t w = p.width_pixels, h = p.height_pixels, stride = default_stride(p.format, w);
+    std::vector<uint8_t> base(image_bytes(p.format, stride, h), 128);
+    for (uint32_t y = 0; y < h; ++y) {
+        uint8_t *row = base.data() + (size_t)y * stride;
+        for (uint32_t x = 0; x < w; ++x) {
+            switch (p.format) {
+            case OB2_FORMAT_YUYV:
+                row[2 * x] = (uint8_t)(16 + 219 * x / w);
+                break;
+            case OB2_FORMAT_RGB:
+                row[3 * x] = (uint8_t)(255 * x / w);
+                row[3 * x + 1] = (uint8_t)(255 * y / h);
+                break;
+            case OB2_FORMAT_BGR:
+                row[3 * x + 2] = (uint8_t)(255 * x / w);
+                row[3 * x + 1] = (uint8_t)(255 * y / h);
+                break;
+            case OB2_FORMAT_Y16:
+                ((uint16_t *)row)[x] = (uint16_t)(camera == OB2_CAMERA_DEPTH ? 800 + 1200 * y / h : 100 + 700 * x / w);
+                break;
+            default:  // NV12 的 Y 平面和 Y8
+                row[x] = (uint8_t)(camera == OB2_CAMERA_COLOR ? 16 + 219 * x / w : 30 + 200 * x / w);
+                break;
+            }
+        }
+    }
+    return base;
+}
+
+}  // namespace ob2sim
+
+using namespace ob2sim;
+
+ob2_image_t sim_stream::make_image(uint64_t frame, uint64_t device_usec, uint64_t system_usec) const {
+    std::unique_ptr<OB2ImageImpl> im(new OB2ImageImpl());
+    im->camera = camera;
+    im->format = profile.format;
+    im->device_timestamp_usec = device_usec;
+    im->system_timestamp_usec = system_usec;
+    if (profile.format == OB2_FORMAT_MJPG) {
+        im->storage = files[frame % files.size()];
+        if (!jpeg_size(im->storage, im->width, im->height)) {
+            im->width = profile.width_pixels;
+            im->height = profile.height_pixels;
+        }
+    }
+    else {
+        im->width = profile.width_pixels;
+        im->height = profile.height_pixels;
+        im->stride = default_stride(profile.format, im->width);
+        im->storage = base;
+        const uint32_t x0 = (uint32_t)(frame * 8 % im->width), x1 = std::min(x0 + 16, im->width);
+        for (uint32_t y = 0; y < im->height; ++y) {
+            for (uint32_t x = x0; x < x1; ++x) {
+                draw_bar(im->storage.data() + (size_t)y * im->stride, camera, profile.format, x);
+            }
+        }
+        if (profile.format == OB2_FORMAT_Y16) {
+            im->bits = camera == OB2_CAMERA_DEPTH ? 16 : 10;
+        }
+    }
+    im->buffer = im->storage.data();
+    im->size = (uint32_t)im->storage.size();
+    return im.release();
+}
+
+static ob2_camera_type_t check_camera(ob2_camera_type_t camera_type) {
+    if (camera_type != OB2_CAMERA_COLOR && camera_type != OB2_CAMERA_DEPTH && camera_type != OB2_CAMERA_IR) {
+        throw logic_error("Invalid camera type " + std::to_string((int)camera_type));
+    }
+    return camera_type;
+}
+
+// 每个相机支持配置的分辨率，外加半分辨率和 15 fps 两种，第一个为默认配置。MJPG 的分辨率取自文件，只有一种
+static std::vector<ob2_camera_stream_profile_t> profile_list(const OB2DeviceImpl *dev, ob2_camera_type_t camera_type) {
+    const ob2_camera_stream_profile_t p = dev->config->profiles[check_camera(camera_type)];
+    std::vector<ob2_camera_stream_profile_t> list = {p};
+    if (p.format != OB2_FORMAT_MJPG) {
+        list.push_back({(uint16_t)(p.width_pixels / 2), (uint16_t)(p.height_pixels / 2), p.frame_rate, p.format});
+        if (p.frame_rate > 15) {
+            list.push_back({p.width_pixels, p.height_pixels, 15, p.format});
+        }
+    }
+    return list;
+}
+
+// 把含 OB2_ANY_* 的配置匹配为支持的配置
+static ob2_camera_stream_profile_t resolve_profile(const OB2DeviceImpl *dev, ob2_camera_type_t camera_type, const ob2_camera_stream_profile_t &req) {
+    for (auto &p : profile_list(dev, camera_type)) {
+        if ((req.width_pixels == OB2_ANY_WIDTH || req.width_pixels == p.width_pixels) && (req.height_pixels == OB2_ANY_HEIGHT || req.height_pixels == p.height_pixels)
+            && (req.frame_rate == OB2_ANY_FRAME_RATE || req.frame_rate == p.frame_rate) && (req.format == OB2_ANY_IAMGE_FORMAT || req.format == p.format)) {
+            return p;
+        }
+    }
+    throw logic_error("Unsupported stream profile " + std::to_string(req.width_pixels) + "x" + std::to_string(req.height_pixels) + "@"
+                      + std::to_string(req.frame_rate) + ":" + format_name(req.format) + " for camera " + std::to_string((int)camera_type));
+}
+
+static OB2CamerasConfigImpl default_cameras_config(bool enable_all) {
+    OB2CamerasConfigImpl config;
+    for (int c = 0; c < camera_slots; ++c) {
+        config.profiles[c] = {OB2_ANY_WIDTH, OB2_ANY_HEIGHT, OB2_ANY_FRAME_RATE, OB2_ANY_IAMGE_FORMAT};
+        config.enabled[c] = enable_all && c != OB2_CAMERA_UNKNOWN;
+    }
+    return config;
+}
+
+static std::vector<sim_stream> make_streams(const OB2DeviceImpl *dev, const OB2CamerasConfigImpl &config) {
+    std::vector<sim_stream> streams;
+    for (ob2_camera_type_t camera : {OB2_CAMERA_COLOR, OB2_CAMERA_DEPTH, OB2_CAMERA_IR}) {
+        if (!config.enabled[camera]) {
+            continue;
+        }
+        sim_stream s;
+        s.camera = camera;
+        s.profile = resolve_profile(dev, camera, config.profiles[camera]);
+        const ob2_image_format_t f = s.profile.format;
+        bool supported = camera == OB2_CAMERA_COLOR ? f == OB2_FORMAT_YUYV || f == OB2_FORMAT_NV12 || f == OB2_FORMAT_RGB || f == OB2_FORMAT_BGR
+                                                          || f == OB2_FORMAT_Y8 || f == OB2_FORMAT_MJPG
+                                                    : f == OB2_FORMAT_Y16 || (camera == OB2_CAMERA_IR && f == OB2_FORMAT_Y8);
+        if (!supported) {
+            throw logic_error("Format " + format_name(f) + " is not simulated for camera " + std::to_string((int)camera));
+        }
+        if (f == OB2_FORMAT_MJPG) {
+            // 与 grasp 保存图像的命名一致：目录路径直接拼接序号
+            for (int i = 0;; ++i) {
+                std::string path = dev->config->color_dir + std::to_string(i) + ".jpg";
+                std::FILE *fp = std::fopen(path.c_str(), "rb");
+                if (fp == nullptr) {
+                    break;
+                }
+                std::vector<uint8_t> data;
+                uint8_t chunk[65536];
+                for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), fp)) > 0;) {
+                    data.insert(data.end(), chunk, chunk + n);
+                }
+                std::fclose(fp);
+                s.files.push_back(std::move(data));
+            }
+            if (s.files.empty()) {
+                throw logic_error("MJPG needs OB2SIM_COLOR_DIR with 0.jpg, 1.jpg ..., none found in \"" + dev->config->color_dir + "\"");
+            }
+        }
+        else {
+            s.base = make_base(camera, s.profile);
+        }
+        streams.push_back(std::move(s));
+    }
+    if (streams.empty()) {
+        throw logic_error("No camera stream is enabled");
+    }
+    return streams;
+}
+
+static void deliver_capture(OB2DeviceImpl *dev, ob2_capture_t capture) {
+    if (dev->capture_cb != nullptr) {
+        // 回调取得 capture 的所有权
+        dev->capture_cb(capture, dev->capture_user_data);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(dev->mutex);
+    if (dev->captures.size() >= max_queued_captures) {
+        ob2_capture_release(dev->captures.front(), nullptr);
+        dev->captures.pop_front();
+    }
+    dev->captures.push_back(capture);
+    dev->ready.notify_all();
+}
+
+// 按启用的流中最高的帧率生成 capture，低帧率的流按比例只在部分 capture 中出现。
+// 非实时模式下不等待，时间戳仍按帧率递增
+static void camera_loop(OB2DeviceImpl *dev, uint64_t generation, std::vector<sim_stream> streams) {
+    auto active = [dev, generation] { return dev->cameras_running && dev->camera_generation == generation; };
+    uint64_t fps = 0;
+    for (auto &s : streams) {
+        fps = std::max<uint64_t>(fps, s.profile.frame_rate);
+    }
+    const bool realtime = dev->config->realtime;
+    const uint64_t start = steady_usec();
+    try {
+        for (uint64_t frame = 0; active(); ++frame) {
+            const uint64_t t = start + frame * 1000000 / fps;
+            if (realtime) {
+                std::unique_lock<std::mutex> lock(dev->mutex);
+                dev->ready.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::microseconds(t)), [&active] { return !active(); });
+                if (!active()) {
+                    break;
+                }
+            }
+            const uint64_t device_usec = (realtime ? steady_usec() : t) + dev->clock_offset_usec, sys_usec = system_usec();
+            std::unique_ptr<OB2CaptureImpl> capture(new OB2CaptureImpl());
+            for (auto &s : streams) {
+                const uint64_t k = frame * s.profile.frame_rate / fps;
+                if (frame == 0 || k != (frame - 1) * s.profile.frame_rate / fps) {
+                    capture->images[s.camera] = s.make_image(k, device_usec, sys_usec);
+                }
+            }
+            deliver_capture(dev, capture.release());
+        }
+    }
+    catch (const std::exception &e) {
+        std::fprintf(stderr, "ob2sim: camera stream of device %u stopped: %s\n", dev->index, e.what());
+    }
+}
+
+// 停止并等待生成线程结束。在回调中调用时不能等待自己，回调返回后线程自行退出，由之后的 stop、start 或关闭设备等待
+static void stop_camera_thread(OB2DeviceImpl *dev) {
+    {
+        std::lock_guard<std::mutex> lock(dev->mutex);
+        dev->cameras_running = false;
+    }
+    dev->ready.notify_all();
+    retire_or_join(dev->camera_thread, dev->thread_mutex, dev->retired_threads);
+    join_retired(dev->thread_mutex, dev->retired_threads);
+}
+
+static void start_camera_thread(OB2DeviceImpl *dev, const OB2CamerasConfigImpl &config) {
+    std::vector<sim_stream> streams = make_streams(dev, config);
+    dev->active = config;
+    const uint64_t generation = ++dev->camera_generation;
+    dev->cameras_running = true;
+    std::lock_guard<std::mutex> lock(dev->thread_mutex);
+    dev->camera_thread = std::thread(camera_loop, dev, generation, std::move(streams));
+}
+
+namespace ob2sim {
+
+void stop_cameras(OB2DeviceImpl *dev) {
+    stop_camera_thread(dev);
+    std::lock_guard<std::mutex> lock(dev->mutex);
+    for (ob2_capture_t capture : dev->captures) {
+        ob2_capture_release(capture, nullptr);
+    }
+    dev->captures.clear();
+    dev->capture_cb = nullptr;
+    dev->capture_user_data = nullptr;
+}
+
+}  // namespace ob2sim
+
+static void start_cameras(ob2_device_t device_handle, const ob2_cameras_config_t cameras_config_handle, ob2_capture_cb_t cb, void *user_data) {
+    check_handle(device_handle, "device_handle");
+    if (device_handle->cameras_running) {
+        throw logic_error("Cameras are already started");
+    }
+    // 空配置按默认配置启动全部相机
+    OB2CamerasConfigImpl config = cameras_config_handle != OB2_DEFAULT_CAMERAS_CONFIG ? *cameras_config_handle : default_cameras_config(true);
+    stop_cameras(device_handle);
+    device_handle->capture_cb = cb;
+    device_handle->capture_user_data = user_data;
+    start_camera_thread(device_handle, config);
+}
+
+uint32_t ob2_device_get_supported_camera_count(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return 3;
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_camera_type_t ob2_device_get_supported_camera_type(ob2_device_t device_handle, uint32_t index, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    const ob2_camera_type_t cameras[] = {OB2_CAMERA_COLOR, OB2_CAMERA_DEPTH, OB2_CAMERA_IR};
+    if (index >= 3) {
+        throw logic_error("Camera index " + std::to_string(index) + " out of range");
+    }
+    return cameras[index];
+    OB2SIM_CATCH(status, OB2_CAMERA_UNKNOWN)
+}
+
+uint32_t ob2_device_get_camera_stream_profile_count(ob2_device_t device_handle, ob2_camera_type_t camera_type, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return (uint32_t)profile_list(check_handle(device_handle, "device_handle"), camera_type).size();
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_camera_stream_profile_t ob2_device_get_camera_stream_profile(ob2_device_t device_handle, ob2_camera_type_t camera_type, uint32_t index,
+                                                                 ob2_status_t *status) {
+    ob2_camera_stream_profile_t profile = {0, 0, 0, OB2_FORMAT_UNKNOWN};
+    OB2SIM_TRY(status)
+    auto list = profile_list(check_handle(device_handle, "device_handle"), camera_type);
+    if (index >= list.size()) {
+        throw logic_error("Stream profile index " + std::to_string(index) + " out of range");
+    }
+    return list[index];
+    OB2SIM_CATCH(status, profile)
+}
+
+// 替身不做对齐，任意深度配置都视为可对齐
+uint32_t ob2_device_get_alignable_camera_stream_profile_count(ob2_device_t device_handle, ob2_images_align_mode_t image_align_mode,
+                                                              ob2_camera_stream_profile_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    if (image_align_mode == OB2_IMAGES_ALIGN_MODE_DISABLE) {
+        throw logic_error("Align mode must not be OB2_IMAGES_ALIGN_MODE_DISABLE");
+    }
+    return (uint32_t)profile_list(device_handle, OB2_CAMERA_DEPTH).size();
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_camera_stream_profile_t ob2_device_get_alignable_camera_stream_profile(ob2_device_t device_handle, ob2_images_align_mode_t align_mode,
+                                                                           ob2_camera_stream_profile_t, uint32_t index, ob2_status_t *status) {
+    ob2_camera_stream_profile_t profile = {0, 0, 0, OB2_FORMAT_UNKNOWN};
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    if (align_mode == OB2_IMAGES_ALIGN_MODE_DISABLE) {
+        throw logic_error("Align mode must not be OB2_IMAGES_ALIGN_MODE_DISABLE");
+    }
+    auto list = profile_list(device_handle, OB2_CAMERA_DEPTH);
+    if (index >= list.size()) {
+        throw logic_error("Stream profile index " + std::to_string(index) + " out of range");
+    }
+    return list[index];
+    OB2SIM_CATCH(status, profile)
+}
+
+ob2_cameras_config_t ob2_device_create_cameras_config(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return new OB2CamerasConfigImpl(default_cameras_config(false));
+    OB2SIM_CATCH(status, nullptr)
+}
+
+void ob2_cameras_config_release(ob2_cameras_config_t cameras_config_handle, ob2_status_t *status) {
+    set_status(status, OB2_STATUS_OK, "", "");
+    delete cameras_config_handle;
+}
+
+void ob2_cameras_config_set_camera_stream_profile(ob2_cameras_config_t cameras_config_handle, ob2_camera_type_t camera_type,
+                                                  const ob2_camera_stream_profile_t *stream_profile, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle")->profiles[check_camera(camera_type)] = *check_handle(stream_profile, "stream_profile");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_cameras_config_enable_camera_stream(ob2_cameras_config_t cameras_config_handle, ob2_camera_type_t camera_type, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle")->enabled[check_camera(camera_type)] = true;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_cameras_config_set_and_enable_camera_stream(ob2_cameras_config_t cameras_config_handle, ob2_camera_type_t camera_type, uint32_t width_pixels,
+                                                     uint32_t height_pixels, uint32_t frame_rate, ob2_image_format_t format, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle");
+    check_camera(camera_type);
+    cameras_config_handle->profiles[camera_type] = {(uint16_t)width_pixels, (uint16_t)height_pixels, (uint16_t)frame_rate, format};
+    cameras_config_handle->enabled[camera_type] = true;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_cameras_config_disable_camera_stream(ob2_cameras_config_t cameras_config_handle, ob2_camera_type_t camera_type, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle")->enabled[check_camera(camera_type)] = false;
+    OB2SIM_CATCH(status, )
+}
+
+// 以下模式只记录：同一 capture 中的图像总是同时生成，对齐不改变深度图像
+void ob2_cameras_config_set_images_sync_mode(ob2_cameras_config_t cameras_config_handle, ob2_images_sync_mode_t images_sync_mode, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle")->sync_mode = images_sync_mode;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_cameras_config_set_produce_capture_policy(ob2_cameras_config_t cameras_config_handle, ob2_produce_capture_policy_t policy, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle")->policy = policy;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_cameras_config_set_images_align_mode(ob2_cameras_config_t cameras_config_handle, ob2_images_align_mode_t mode, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle")->align_mode = mode;
+    OB2SIM_CATCH(status, )
+}
+
+// 设备间的硬件同步不模拟
+void ob2_cameras_config_set_cameras_sync_mode(ob2_cameras_config_t cameras_config_handle, ob2_cameras_sync_mode_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_cameras_config_set_cameras_sync_delay_usec(ob2_cameras_config_t cameras_config_handle, uint32_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_cameras_config_set_wired_sync_mode(ob2_cameras_config_t cameras_config_handle, ob2_wired_sync_mode_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_cameras_config_set_secondary_delay_off_primary_usec(ob2_cameras_config_t cameras_config_handle, uint32_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(cameras_config_handle, "cameras_config_handle");
+    OB2SIM_CATCH(status, )
+}
+
+ob2_cameras_calibration_t ob2_device_get_cameras_calibration(ob2_device_t device_handle, const ob2_cameras_config_t cameras_config_handle,
+                                                             ob2_status_t *status) {
+    ob2_cameras_calibration_t cal;
+    std::memset(&cal, 0, sizeof(cal));
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    OB2CamerasConfigImpl config = cameras_config_handle != OB2_DEFAULT_CAMERAS_CONFIG ? *cameras_config_handle : default_cameras_config(true);
+    // 深度和 IR 来自同一传感器，只启用 IR 时按 IR 的分辨率给出深度内参
+    ob2_camera_type_t depth = config.enabled[OB2_CAMERA_IR] && !config.enabled[OB2_CAMERA_DEPTH] ? OB2_CAMERA_IR : OB2_CAMERA_DEPTH;
+    return default_calibration(resolve_profile(device_handle, OB2_CAMERA_COLOR, config.profiles[OB2_CAMERA_COLOR]),
+                               resolve_profile(device_handle, depth, config.profiles[depth]));
+    OB2SIM_CATCH(status, cal)
+}
+
+void ob2_device_start_cameras(ob2_device_t device_handle, const ob2_cameras_config_t cameras_config_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    start_cameras(device_handle, cameras_config_handle, nullptr, nullptr);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_device_start_cameras_with_callback(ob2_device_t device_handle, const ob2_cameras_config_t cameras_config_handle, ob2_capture_cb_t cb, void *user_data,
+                                            ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    start_cameras(device_handle, cameras_config_handle, check_handle(cb, "cb"), user_data);
+    OB2SIM_CATCH(status, )
+}
+
+// 以新配置重启生成线程，保留回调和未取走的 capture
+void ob2_device_update_cameras_config(ob2_device_t device_handle, const ob2_cameras_config_t cameras_config_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    if (!device_handle->cameras_running) {
+        throw logic_error("Cameras are not started");
+    }
+    OB2CamerasConfigImpl config = cameras_config_handle != OB2_DEFAULT_CAMERAS_CONFIG ? *cameras_config_handle : default_cameras_config(true);
+    make_streams(device_handle, config);
+    stop_camera_thread(device_handle);
+    start_camera_thread(device_handle, config);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_device_stop_cameras(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    stop_cameras(check_handle(device_handle, "device_handle"));
+    OB2SIM_CATCH(status, )
+}
+
+ob2_capture_t ob2_device_get_capture(ob2_device_t device_handle, int32_t timeout_msec, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    std::unique_lock<std::mutex> lock(device_handle->mutex);
+    auto ready = [device_handle] { return !device_handle->captures.empty() || !device_handle->cameras_running; };
+    if (timeout_msec == OB2_WAIT_INFINITE) {
+        device_handle->ready.wait(lock, ready);
+    }
+    else if (!device_handle->ready.wait_for(lock, std::chrono::milliseconds(std::max(0, timeout_msec)), ready)) {
+        throw std::runtime_error("Timeout waiting for capture");
+    }
+    if (device_handle->captures.empty()) {
+        throw std::runtime_error("Cameras are not started");
+    }
+    ob2_capture_t capture = device_handle->captures.front();
+    device_handle->captures.pop_front();
+    return capture;
+    OB2SIM_CATCH(status, nullptr)
+}
+
+ob2_capture_t ob2_capture_create(ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return new OB2CaptureImpl();
+    OB2SIM_CATCH(status, nullptr)
+}
+
+void ob2_capture_reference(ob2_capture_t capture_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    ++check_handle(capture_handle, "capture_handle")->refs;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_capture_release(ob2_capture_t capture_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    if (--check_handle(capture_handle, "capture_handle")->refs == 0) {
+        delete capture_handle;
+    }
+    OB2SIM_CATCH(status, )
+}
+
+// 返回新的引用，capture 中没有该相机的图像时返回 NULL
+ob2_image_t ob2_capture_get_image(ob2_capture_t capture_handle, ob2_camera_type_t camera_type, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    ob2_image_t image = check_handle(capture_handle, "capture_handle")->images[check_camera(camera_type)];
+    if (image != nullptr) {
+        ++image->refs;
+    }
+    return image;
+    OB2SIM_CATCH(status, nullptr)
+}
+
+ob2_image_t ob2_capture_get_color_image(ob2_capture_t capture_handle, ob2_status_t *status) {
+    return ob2_capture_get_image(capture_handle, OB2_CAMERA_COLOR, status);
+}
+
+ob2_image_t ob2_capture_get_depth_image(ob2_capture_t capture_handle, ob2_status_t *status) {
+    return ob2_capture_get_image(capture_handle, OB2_CAMERA_DEPTH, status);
+}
+
+ob2_image_t ob2_capture_get_ir_image(ob2_capture_t capture_handle, ob2_status_t *status) {
+    return ob2_capture_get_image(capture_handle, OB2_CAMERA_IR, status);
+}
+
+// capture 持有新图像的一个引用，并释放原有图像
+void ob2_capture_set_image(ob2_capture_t capture_handle, ob2_camera_type_t camera_type, ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    ob2_image_t &slot = check_handle(capture_handle, "capture_handle")->images[check_camera(camera_type)];
+    if (image_handle != nullptr) {
+        ++image_handle->refs;
+    }
+    ob2_image_t old = slot;
+    slot = image_handle;
+    if (old != nullptr) {
+        ob2_image_release(old, nullptr);
+    }
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_capture_set_color_image(ob2_capture_t capture_handle, ob2_image_t image_handle, ob2_status_t *status) {
+    ob2_capture_set_image(capture_handle, OB2_CAMERA_COLOR, image_handle, status);
+}
+
+void ob2_capture_set_depth_image(ob2_capture_t capture_handle, ob2_image_t image_handle, ob2_status_t *status) {
+    ob2_capture_set_image(capture_handle, OB2_CAMERA_DEPTH, image_handle, status);
+}
+
+void ob2_capture_set_ir_image(ob2_capture_t capture_handle, ob2_image_t image_handle, ob2_status_t *status) {
+    ob2_capture_set_image(capture_handle, OB2_CAMERA_IR, image_handle, status);
+}
+
+ob2_image_t ob2_image_create(ob2_camera_type_t source_camera_type, ob2_image_format_t format, uint32_t width_pixels, uint32_t height_pixels,
+                             uint32_t stride_bytes, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    if (stride_bytes == 0) {
+        stride_bytes = default_stride(format, width_pixels);
+    }
+    if (stride_bytes == 0) {
+        throw logic_error("Cannot determine the size of format " + format_name(format) + ", use ob2_image_create_from_buffer");
+    }
+    std::unique_ptr<OB2ImageImpl> im(new OB2ImageImpl());
+    im->camera = source_camera_type;
+    im->format = format;
+    im->width = width_pixels;
+    im->height = height_pixels;
+    im->stride = stride_bytes;
+    im->storage.resize(image_bytes(format, stride_bytes, height_pixels));
+    im->buffer = im->storage.data();
+    im->size = (uint32_t)im->storage.size();
+    im->bits = format == OB2_FORMAT_Y16 ? 16 : 8;
+    return im.release();
+    OB2SIM_CATCH(status, nullptr)
+}
+
+ob2_image_t ob2_image_create_from_buffer(ob2_camera_type_t source_camera_type, ob2_image_format_t format, uint32_t width_pixels, uint32_t height_pixels,
+                                         uint32_t stride_bytes, uint8_t *buffer, uint32_t buffer_size, ob2_buffer_release_cb_t buffer_release_cb,
+                                         void *user_data, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::unique_ptr<OB2ImageImpl> im(new OB2ImageImpl());
+    im->camera = source_camera_type;
+    im->format = format;
+    im->width = width_pixels;
+    im->height = height_pixels;
+    im->stride = stride_bytes != 0 ? stride_bytes : default_stride(format, width_pixels);
+    im->buffer = check_handle(buffer, "buffer");
+    im->size = buffer_size;
+    im->release_cb = buffer_release_cb;
+    im->release_user_data = user_data;
+    im->bits = format == OB2_FORMAT_Y16 ? 16 : 8;
+    return im.release();
+    OB2SIM_CATCH(status, nullptr)
+}
+
+void ob2_image_reference(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    ++check_handle(image_handle, "image_handle")->refs;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_image_release(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    if (--check_handle(image_handle, "image_handle")->refs == 0) {
+        delete image_handle;
+    }
+    OB2SIM_CATCH(status, )
+}
+
+uint8_t *ob2_image_get_buffer(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->buffer;
+    OB2SIM_CATCH(status, nullptr)
+}
+
+uint32_t ob2_image_get_size(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->size;
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_image_format_t ob2_image_get_format(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->format;
+    OB2SIM_CATCH(status, OB2_FORMAT_UNKNOWN)
+}
+
+uint32_t ob2_image_get_width_pixels(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->width;
+    OB2SIM_CATCH(status, 0)
+}
+
+uint32_t ob2_image_get_height_pixels(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->height;
+    OB2SIM_CATCH(status, 0)
+}
+
+uint32_t ob2_image_get_stride_bytes(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->stride;
+    OB2SIM_CATCH(status, 0)
+}
+
+uint64_t ob2_image_get_device_timestamp_usec(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->device_timestamp_usec;
+    OB2SIM_CATCH(status, 0)
+}
+
+uint64_t ob2_image_get_system_timestamp_usec(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->system_timestamp_usec;
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_camera_type_t ob2_image_get_source_camera_type(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->camera;
+    OB2SIM_CATCH(status, OB2_CAMERA_UNKNOWN)
+}
+
+uint8_t ob2_image_get_available_bits_for_each_pixel(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->bits;
+    OB2SIM_CATCH(status, 0)
+}
+
+float ob2_depth_image_get_value_scale(ob2_image_t image_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return check_handle(image_handle, "image_handle")->value_scale;
+    OB2SIM_CATCH(status, 0)
+}
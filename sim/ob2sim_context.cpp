@@ -0,0 +1,470 @@
+#include "ob2sim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace ob2sim {
+
+static const struct {
+    ob2_image_format_t format;
+    const char *name;
+} format_names[] = {{OB2_FORMAT_YUYV, "YUYV"}, {OB2_FORMAT_NV12, "NV12"}, {OB2_FORMAT_RGB, "RGB"}, {OB2_FORMAT_BGR, "BGR"},
+                    {OB2_FORMAT_Y8, "Y8"},     {OB2_FORMAT_Y16, "Y16"},   {OB2_FORMAT_MJPG, "MJPG"}};
+
+std::string format_name(ob2_image_format_t format) {
+    for (auto &f : format_names) {
+        if (f.format == format) {
+            return f.name;
+        }
+    }
+    return std::to_string((int)format);
+}
+
+ob2_image_format_t parse_format(const std::string &name) {
+    for (auto &f : format_names) {
+        if (name == f.name) {
+            return f.format;
+        }
+    }
+    throw logic_error("Unsupported image format " + name);
+}
+
+// 形如 1920x1080@30:YUYV
+static ob2_camera_stream_profile_t parse_profile(const std::string &s) {
+    unsigned w = 0, h = 0, fps = 0;
+    char format[16] = {0};
+    if (std::sscanf(s.c_str(), "%ux%u@%u:%15s", &w, &h, &fps, format) != 4 || w == 0 || h == 0 || fps == 0) {
+        throw logic_error("Invalid stream profile \"" + s + "\", expected WIDTHxHEIGHT@FPS:FORMAT");
+    }
+    return {(uint16_t)w, (uint16_t)h, (uint16_t)fps, parse_format(format)};
+}
+
+sim_config load_config(const char *config_file_path) {
+    std::map<std::string, std::string> values;
+    if (config_file_path != nullptr && config_file_path[0] != '\0') {
+        std::ifstream in(config_file_path);
+        if (!in) {
+            throw std::runtime_error(std::string("Fail to open ") + config_file_path);
+        }
+        for (std::string line; std::getline(in, line);) {
+            size_t eq = line.find('=');
+            if (line.empty() || line[0] == '#' || eq == std::string::npos) {
+                continue;
+            }
+            values[line.substr(0, eq)] = line.substr(eq + 1);
+        }
+    }
+    for (const char *key : {"OB2SIM_DEVICES", "OB2SIM_COLOR", "OB2SIM_DEPTH", "OB2SIM_IR", "OB2SIM_COLOR_DIR", "OB2SIM_REALTIME"}) {
+        if (const char *v = std::getenv(key)) {
+            values[key] = v;
+        }
+    }
+
+    sim_config c;
+    if (values.count("OB2SIM_DEVICES")) {
+        c.devices = std::max(0, std::atoi(values["OB2SIM_DEVICES"].c_str()));
+    }
+    const struct {
+        const char *key;
+        ob2_camera_type_t camera;
+    } streams[] = {{"OB2SIM_COLOR", OB2_CAMERA_COLOR}, {"OB2SIM_DEPTH", OB2_CAMERA_DEPTH}, {"OB2SIM_IR", OB2_CAMERA_IR}};
+    for (auto &s : streams) {
+        if (values.count(s.key)) {
+            c.profiles[s.camera] = parse_profile(values[s.key]);
+        }
+    }
+    c.color_dir = values["OB2SIM_COLOR_DIR"];
+    if (!c.color_dir.empty()) {
+        c.profiles[OB2_CAMERA_COLOR].format = OB2_FORMAT_MJPG;
+    }
+    if (values.count("OB2SIM_REALTIME")) {
+        c.realtime = values["OB2SIM_REALTIME"] != "0";
+    }
+    return c;
+}
+
+ob2_cameras_calibration_t default_calibration(const ob2_camera_stream_profile_t &color, const ob2_camera_stream_profile_t &depth) {
+    auto intrinsic = [](const ob2_camera_stream_profile_t &p, float hfov_deg) {
+        ob2_camera_intrinsic_t in;
+        in.fx = in.fy = (float)(p.width_pixels / 2.0 / std::tan(hfov_deg / 2 * M_PI / 180));
+        in.cx = p.width_pixels / 2.0f;
+        in.cy = p.height_pixels / 2.0f;
+        in.width = (int16_t)p.width_pixels;
+        in.height = (int16_t)p.height_pixels;
+        return in;
+    };
+    ob2_cameras_calibration_t cal;
+    std::memset(&cal, 0, sizeof(cal));
+    cal.color_Intrinsic = intrinsic(color, 70);
+    cal.depth_intrinsic = intrinsic(depth, 75);
+    // 深度（IR）相机在彩色相机左侧 25 mm，光轴平行
+    const float rot[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    std::memcpy(cal.transform.rot, rot, sizeof(rot));
+    cal.transform.trans[0] = -25;
+    return cal;
+}
+
+}  // namespace ob2sim
+
+using namespace ob2sim;
+
+OB2DeviceImpl::~OB2DeviceImpl() {
+    stop_cameras(this);
+    stop_imu(this);
+    abandon_retired(thread_mutex, retired_threads, "device");
+}
+
+static const ob2_device_info_t &device_info_template() {
+    static ob2_device_info_t info = [] {
+        ob2_device_info_t i;
+        std::memset(&i, 0, sizeof(i));
+        i.vid = 0x2bc5;
+        i.pid = 0xffff;
+        std::strcpy(i.connection_type, "Simulator");
+        std::strcpy(i.name, "OB2 Simulator");
+        std::strcpy(i.firmware_version, "sim-1.0");
+        std::strcpy(i.hardware_version, "sim");
+        i.technology = OB2_3D_TECH_INDIRECT_TOF;
+        return i;
+    }();
+    return info;
+}
+
+ob2_version_t ob2_get_version(void) {
+    return {2, 0, 0};
+}
+
+ob2_version_t ob2_get_core_version(void) {
+    return {2, 0, 0};
+}
+
+void ob2_set_log_severity_threshold(ob2_logger_type_t, ob2_log_severity_t, ob2_status_t *status) {
+    set_status(status, OB2_STATUS_OK, "", "");
+}
+
+void ob2_set_log_output_directory(const char *, ob2_status_t *status) {
+    set_status(status, OB2_STATUS_OK, "", "");
+}
+
+ob2_context_t ob2_create_context_with_config(const char *config_file_path, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::unique_ptr<OB2ContextImpl> ctx(new OB2ContextImpl());
+    ctx->config = std::make_shared<sim_config>(load_config(config_file_path));
+    for (int i = 0; i < ctx->config->devices; ++i) {
+        ob2_device_installation_info_t info;
+        std::memset(&info, 0, sizeof(info));
+        info.vid = device_info_template().vid;
+        info.pid = device_info_template().pid;
+        std::snprintf(info.url, sizeof(info.url), "sim://%d", i);
+        std::snprintf(info.serial_number, sizeof(info.serial_number), "SIM%07d", i);
+        std::strcpy(info.connection_type, device_info_template().connection_type);
+        ctx->devices.push_back(info);
+    }
+    return ctx.release();
+    OB2SIM_CATCH(status, nullptr)
+}
+
+ob2_context_t ob2_create_context(ob2_status_t *status) {
+    return ob2_create_context_with_config(OB2_DEFAULT_SDK_CONFIG_FILE_PATH, status);
+}
+
+void ob2_release_context(ob2_context_t context_handle, ob2_status_t *status) {
+    set_status(status, OB2_STATUS_OK, "", "");
+    delete context_handle;
+}
+
+// 模拟的设备不会插拔，回调永远不会被调用
+void ob2_context_set_device_installed_callback(ob2_context_t context_handle, ob2_device_info_cb_t, void *, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(context_handle, "context_handle");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_context_set_device_removed_callback(ob2_context_t context_handle, ob2_device_info_cb_t, void *, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(context_handle, "context_handle");
+    OB2SIM_CATCH(status, )
+}
+
+uint32_t ob2_context_get_installed_device_count(ob2_context_t context_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return (uint32_t)check_handle(context_handle, "context_handle")->devices.size();
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_device_installation_info_t ob2_context_get_installed_device_info(ob2_context_t context_handle, uint32_t index, ob2_status_t *status) {
+    ob2_device_installation_info_t info;
+    std::memset(&info, 0, sizeof(info));
+    OB2SIM_TRY(status)
+    check_handle(context_handle, "context_handle");
+    if (index >= context_handle->devices.size()) {
+        throw logic_error("Device index " + std::to_string(index) + " out of range");
+    }
+    return context_handle->devices[index];
+    OB2SIM_CATCH(status, info)
+}
+
+ob2_device_t ob2_context_open_device(ob2_context_t context_handle, uint32_t index, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(context_handle, "context_handle");
+    if (index >= context_handle->devices.size()) {
+        throw std::runtime_error("No device at index " + std::to_string(index));
+    }
+    std::unique_ptr<OB2DeviceImpl> dev(new OB2DeviceImpl());
+    dev->index = index;
+    dev->installation = context_handle->devices[index];
+    dev->config = context_handle->config;
+    // 各设备的时钟相差 1 s 左右
+    dev->clock_offset_usec = (uint64_t)index * 1000003;
+    return dev.release();
+    OB2SIM_CATCH(status, nullptr)
+}
+
+ob2_device_t ob2_context_open_device_by_serial_number(ob2_context_t context_handle, const char *serial_number, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(context_handle, "context_handle");
+    for (uint32_t i = 0; i < context_handle->devices.size(); ++i) {
+        if (std::strncmp(context_handle->devices[i].serial_number, check_handle(serial_number, "serial_number"), sizeof(ob2_device_installation_info_t::serial_number)) == 0) {
+            return ob2_context_open_device(context_handle, i, status);
+        }
+    }
+    throw std::runtime_error(std::string("No device with serial number ") + serial_number);
+    OB2SIM_CATCH(status, nullptr)
+}
+
+ob2_device_t ob2_context_open_device_by_url(ob2_context_t context_handle, const char *url, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(context_handle, "context_handle");
+    for (uint32_t i = 0; i < context_handle->devices.size(); ++i) {
+        if (std::strncmp(context_handle->devices[i].url, check_handle(url, "url"), sizeof(ob2_device_installation_info_t::url)) == 0) {
+            return ob2_context_open_device(context_handle, i, status);
+        }
+    }
+    throw std::runtime_error(std::string("No device at ") + url);
+    OB2SIM_CATCH(status, nullptr)
+}
+
+ob2_device_t ob2_context_open_net_device(ob2_context_t context_handle, const char *address, uint32_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(context_handle, "context_handle");
+    throw std::runtime_error(std::string("Network devices are not simulated: ") + (address ? address : ""));
+    OB2SIM_CATCH(status, nullptr)
+}
+
+void ob2_device_close(ob2_device_t device_handle, ob2_status_t *status) {
+    set_status(status, OB2_STATUS_OK, "", "");
+    delete device_handle;
+}
+
+ob2_device_info_t ob2_device_get_info(ob2_device_t device_handle, ob2_status_t *status) {
+    ob2_device_info_t info = device_info_template();
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    std::memcpy(info.url, device_handle->installation.url, sizeof(info.url));
+    std::memcpy(info.serial_number, device_handle->installation.serial_number, sizeof(info.serial_number));
+    return info;
+    OB2SIM_CATCH(status, info)
+}
+
+void ob2_device_update_firmware(ob2_device_t device_handle, const char *, ob2_firmware_update_state_cb_t, void *, ob2_enable_ctrl_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    throw std::runtime_error("Firmware update is not simulated");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_device_reboot(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    stop_cameras(check_handle(device_handle, "device_handle"));
+    stop_imu(device_handle);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_device_sync_clock_with_host(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    // 同步后设备时间戳与主机系统时间一致
+    check_handle(device_handle, "device_handle")->clock_offset_usec = system_usec() - steady_usec();
+    OB2SIM_CATCH(status, )
+}
+
+// 属性：只保存设置的值，不影响合成的图像。未设置过的属性取能力描述中的默认值
+static const struct {
+    ob2_command_id_t id;
+    ob2_command_type_t type;
+    const char *name;
+    float min, max, step, def;
+} simulated_properties[] = {
+    {OB2_PROP_LASER_BOOL, OB2_BOOL_PROPERTY, "Laser", 0, 1, 1, 1},
+    {OB2_PROP_LDP_BOOL, OB2_BOOL_PROPERTY, "LDP", 0, 1, 1, 1},
+    {OB2_PROP_DEPTH_MIRROR_BOOL, OB2_BOOL_PROPERTY, "Depth mirror", 0, 1, 1, 0},
+    {OB2_PROP_MIN_DEPTH_INT, OB2_INT_PROPERTY, "Min depth", 0, 65535, 1, 0},
+    {OB2_PROP_MAX_DEPTH_INT, OB2_INT_PROPERTY, "Max depth", 0, 65535, 1, 65535},
+    {OB2_PROP_LASER_CURRENT_FLOAT, OB2_FLOAT_PROPERTY, "Laser current", 0, 10, 0.1f, 5},
+    {OB2_PROP_COLOR_AUTO_EXPOSURE_BOOL, OB2_BOOL_PROPERTY, "Color auto exposure", 0, 1, 1, 1},
+    {OB2_PROP_COLOR_EXPOSURE_INT, OB2_INT_PROPERTY, "Color exposure", 1, 10000, 1, 156},
+    {OB2_PROP_COLOR_GAIN_INT, OB2_INT_PROPERTY, "Color gain", 0, 128, 1, 16},
+    {OB2_PROP_IR_EXPOSURE_INT, OB2_INT_PROPERTY, "IR exposure", 1, 10000, 1, 1000},
+    {OB2_PROP_IR_GAIN_INT, OB2_INT_PROPERTY, "IR gain", 0, 128, 1, 16},
+};
+
+static const auto &find_property(ob2_command_id_t id) {
+    for (auto &p : simulated_properties) {
+        if (p.id == id) {
+            return p;
+        }
+    }
+    throw std::runtime_error("Command " + std::to_string((int)id) + " is not supported by the simulator");
+}
+
+static ob2_command_info_t command_info(const decltype(simulated_properties[0]) &p) {
+    ob2_command_info_t info;
+    std::memset(&info, 0, sizeof(info));
+    info.id = p.id;
+    info.type = p.type;
+    info.version = 1;
+    std::snprintf(info.name, sizeof(info.name), "%s", p.name);
+    info.permission = OB2_PERMISSION_READ_WRITE;
+    return info;
+}
+
+static float get_property(ob2_device_t dev, ob2_command_id_t id) {
+    auto &p = find_property(id);
+    std::lock_guard<std::mutex> lock(check_handle(dev, "device_handle")->property_mutex);
+    auto it = dev->properties.find(id);
+    return it != dev->properties.end() ? it->second : p.def;
+}
+
+static void set_property(ob2_device_t dev, ob2_command_id_t id, float value) {
+    auto &p = find_property(id);
+    if (value < p.min || value > p.max) {
+        throw logic_error(std::string(p.name) + " value out of range");
+    }
+    std::lock_guard<std::mutex> lock(check_handle(dev, "device_handle")->property_mutex);
+    dev->properties[id] = value;
+}
+
+uint32_t ob2_device_get_supported_command_count(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return (uint32_t)(sizeof(simulated_properties) / sizeof(simulated_properties[0]));
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_command_info_t ob2_device_get_supported_command_info(ob2_device_t device_handle, uint32_t index, ob2_status_t *status) {
+    ob2_command_info_t info;
+    std::memset(&info, 0, sizeof(info));
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    if (index >= sizeof(simulated_properties) / sizeof(simulated_properties[0])) {
+        throw logic_error("Command index out of range");
+    }
+    return command_info(simulated_properties[index]);
+    OB2SIM_CATCH(status, info)
+}
+
+ob2_command_info_t ob2_device_get_supported_command_info_by_id(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_status_t *status) {
+    ob2_command_info_t info;
+    std::memset(&info, 0, sizeof(info));
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return command_info(find_property(command_id));
+    OB2SIM_CATCH(status, info)
+}
+
+bool ob2_device_check_command_access_permission(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_access_permission_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    for (auto &p : simulated_properties) {
+        if (p.id == command_id) {
+            return true;
+        }
+    }
+    return false;
+    OB2SIM_CATCH(status, false)
+}
+
+bool ob2_device_get_bool_property_value(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return get_property(device_handle, command_id) != 0;
+    OB2SIM_CATCH(status, false)
+}
+
+void ob2_device_set_bool_property_value(ob2_device_t device_handle, ob2_command_id_t command_id, bool value, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    set_property(device_handle, command_id, value ? 1.0f : 0.0f);
+    OB2SIM_CATCH(status, )
+}
+
+bool ob2_device_get_bool_property_default_value(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return find_property(command_id).def != 0;
+    OB2SIM_CATCH(status, false)
+}
+
+int ob2_device_get_int_property_value(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return (int)get_property(device_handle, command_id);
+    OB2SIM_CATCH(status, 0)
+}
+
+void ob2_device_set_int_property_value(ob2_device_t device_handle, ob2_command_id_t command_id, int value, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    set_property(device_handle, command_id, (float)value);
+    OB2SIM_CATCH(status, )
+}
+
+ob2_int_property_capability_t ob2_device_get_int_property_capability(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_status_t *status) {
+    ob2_int_property_capability_t cap = {0, 0, 0, 0};
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    auto &p = find_property(command_id);
+    return {(int)p.max, (int)p.min, (int)p.step, (int)p.def};
+    OB2SIM_CATCH(status, cap)
+}
+
+float ob2_device_get_float_property_value(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return get_property(device_handle, command_id);
+    OB2SIM_CATCH(status, 0)
+}
+
+void ob2_device_set_float_property_value(ob2_device_t device_handle, ob2_command_id_t command_id, float value, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    set_property(device_handle, command_id, value);
+    OB2SIM_CATCH(status, )
+}
+
+ob2_float_property_capability_t ob2_device_get_float_property_capability(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_status_t *status) {
+    ob2_float_property_capability_t cap = {0, 0, 0, 0};
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    auto &p = find_property(command_id);
+    return {p.max, p.min, p.step, p.def};
+    OB2SIM_CATCH(status, cap)
+}
+
+ob2_data_bundle_t *ob2_device_get_structured_data(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    throw std::runtime_error("Structured data " + std::to_string((int)command_id) + " is not supported by the simulator");
+    OB2SIM_CATCH(status, nullptr)
+}
+
+void ob2_device_update_structured_data(ob2_device_t device_handle, ob2_command_id_t command_id, ob2_data_bundle_t *, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    throw std::runtime_error("Structured data " + std::to_string((int)command_id) + " is not supported by the simulator");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_data_bundle_release(ob2_data_bundle_t *data_bundle, ob2_status_t *status) {
+    set_status(status, OB2_STATUS_OK, "", "");
+    if (data_bundle != nullptr) {
+        delete[] data_bundle->data;
+        delete data_bundle;
+    }
+}
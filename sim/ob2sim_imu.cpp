@@ -0,0 +1,327 @@
+#include "ob2sim.hpp"
+
+#include <algorithm>
+
+using namespace ob2sim;
+
+// 未设置回调时缓存的 imu_sample 数，超出后丢弃最旧的
+static const size_t max_queued_imu_samples = 64;
+
+static const struct {
+    ob2_accel_sample_rate_t rate;
+    double hz;
+} simulated_rates[] = {{OB2_SAMPLE_RATE_200_HZ, 200}, {OB2_SAMPLE_RATE_50_HZ, 50}, {OB2_SAMPLE_RATE_100_HZ, 100}, {OB2_SAMPLE_RATE_500_HZ, 500},
+                       {OB2_SAMPLE_RATE_1_KHZ, 1000}};  // 第一个为默认配置
+static const uint32_t simulated_rate_count = sizeof(simulated_rates) / sizeof(simulated_rates[0]);
+
+static double rate_hz(ob2_accel_sample_rate_t rate) {
+    for (auto &r : simulated_rates) {
+        if (r.rate == rate) {
+            return r.hz;
+        }
+    }
+    throw logic_error("Sample rate " + std::to_string((int)rate) + " is not simulated");
+}
+
+static void deliver_imu_sample(OB2DeviceImpl *dev, ob2_imu_sample_t sample) {
+    if (dev->imu_cb != nullptr) {
+        dev->imu_cb(sample, dev->imu_user_data);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(dev->mutex);
+    if (dev->imu_samples.size() >= max_queued_imu_samples) {
+        ob2_imu_sample_release(dev->imu_samples.front(), nullptr);
+        dev->imu_samples.pop_front();
+    }
+    dev->imu_samples.push_back(sample);
+    dev->ready.notify_all();
+}
+
+// 按启用的传感器中最高的采样率生成 imu_sample，每个包含各启用传感器的一次采样
+static void imu_loop(OB2DeviceImpl *dev, uint64_t generation, OB2ImuConfigImpl config) {
+    auto active = [dev, generation] { return dev->imu_running && dev->imu_generation == generation; };
+    double hz = 0;
+    if (config.accel) {
+        hz = rate_hz(config.accel_profile.sample_rate);
+    }
+    if (config.gyro) {
+        hz = std::max(hz, rate_hz(config.gyro_profile.sample_rate));
+    }
+    const bool realtime = dev->config->realtime;
+    const uint64_t start = steady_usec();
+    for (uint64_t n = 0; active(); ++n) {
+        const uint64_t t = start + (uint64_t)(n * 1e6 / hz);
+        if (realtime) {
+            std::unique_lock<std::mutex> lock(dev->mutex);
+            dev->ready.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::microseconds(t)), [&active] { return !active(); });
+            if (!active()) {
+                break;
+            }
+        }
+        const uint64_t device_usec = (realtime ? steady_usec() : t) + dev->clock_offset_usec;
+        OB2ImuSampleImpl *sample = new OB2ImuSampleImpl();
+        if (config.accel) {
+            sample->accel.push_back({device_usec, 35.0f, 0.0f, -1.0f, 0.0f});
+        }
+        if (config.gyro) {
+            sample->gyro.push_back({device_usec, 35.0f, 0.0f, 0.0f, 0.0f});
+        }
+        deliver_imu_sample(dev, sample);
+    }
+}
+
+static void stop_imu_thread(OB2DeviceImpl *dev) {
+    {
+        std::lock_guard<std::mutex> lock(dev->mutex);
+        dev->imu_running = false;
+    }
+    dev->ready.notify_all();
+    retire_or_join(dev->imu_thread, dev->thread_mutex, dev->retired_threads);
+    join_retired(dev->thread_mutex, dev->retired_threads);
+}
+
+static void start_imu_thread(OB2DeviceImpl *dev, const OB2ImuConfigImpl &config) {
+    if (!config.accel && !config.gyro) {
+        throw logic_error("No IMU sensor is enabled");
+    }
+    // 在启动线程前检查采样率
+    if (config.accel) {
+        rate_hz(config.accel_profile.sample_rate);
+    }
+    if (config.gyro) {
+        rate_hz(config.gyro_profile.sample_rate);
+    }
+    const uint64_t generation = ++dev->imu_generation;
+    dev->imu_running = true;
+    std::lock_guard<std::mutex> lock(dev->thread_mutex);
+    dev->imu_thread = std::thread(imu_loop, dev, generation, config);
+}
+
+namespace ob2sim {
+
+void stop_imu(OB2DeviceImpl *dev) {
+    stop_imu_thread(dev);
+    std::lock_guard<std::mutex> lock(dev->mutex);
+    for (ob2_imu_sample_t sample : dev->imu_samples) {
+        ob2_imu_sample_release(sample, nullptr);
+    }
+    dev->imu_samples.clear();
+    dev->imu_cb = nullptr;
+    dev->imu_user_data = nullptr;
+}
+
+}  // namespace ob2sim
+
+static void start_imu(ob2_device_t device_handle, const ob2_imu_config_t imu_config_handle, ob2_imu_sample_cb_t cb, void *user_data) {
+    check_handle(device_handle, "device_handle");
+    if (device_handle->imu_running) {
+        throw logic_error("IMU is already started");
+    }
+    OB2ImuConfigImpl config = imu_config_handle != OB2_DEFAULT_IMU_CONFIG ? *imu_config_handle : OB2ImuConfigImpl();
+    stop_imu(device_handle);
+    device_handle->imu_cb = cb;
+    device_handle->imu_user_data = user_data;
+    start_imu_thread(device_handle, config);
+}
+
+uint32_t ob2_device_get_supported_imu_sensor_count(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return 2;
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_imu_sensor_type_t ob2_device_get_supported_imu_sensor_type(ob2_device_t device_handle, uint32_t index, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    if (index >= 2) {
+        throw logic_error("IMU sensor index " + std::to_string(index) + " out of range");
+    }
+    return index == 0 ? OB2_IMU_SENSOR_ACCEL : OB2_IMU_SENSOR_GYRO;
+    OB2SIM_CATCH(status, OB2_IMU_SENSOR_UNKNOWN)
+}
+
+uint32_t ob2_device_get_accel_stream_profile_count(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return simulated_rate_count;
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_accel_stream_profile_t ob2_device_get_accel_stream_profile(ob2_device_t device_handle, uint32_t index, ob2_status_t *status) {
+    ob2_accel_stream_profile_t profile = OB2ImuConfigImpl().accel_profile;
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    if (index >= simulated_rate_count) {
+        throw logic_error("Accel stream profile index " + std::to_string(index) + " out of range");
+    }
+    profile.sample_rate = simulated_rates[index].rate;
+    return profile;
+    OB2SIM_CATCH(status, profile)
+}
+
+uint32_t ob2_device_get_gyro_stream_profile_count(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return simulated_rate_count;
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_gyro_stream_profile_t ob2_device_get_gyro_stream_profile(ob2_device_t device_handle, uint32_t index, ob2_status_t *status) {
+    ob2_gyro_stream_profile_t profile = OB2ImuConfigImpl().gyro_profile;
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    if (index >= simulated_rate_count) {
+        throw logic_error("Gyro stream profile index " + std::to_string(index) + " out of range");
+    }
+    profile.sample_rate = simulated_rates[index].rate;
+    return profile;
+    OB2SIM_CATCH(status, profile)
+}
+
+ob2_imu_config_t ob2_device_create_imu_config(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    return new OB2ImuConfigImpl();
+    OB2SIM_CATCH(status, nullptr)
+}
+
+void ob2_imu_config_release(ob2_imu_config_t imu_config_handle, ob2_status_t *status) {
+    set_status(status, OB2_STATUS_OK, "", "");
+    delete imu_config_handle;
+}
+
+void ob2_imu_config_set_accel_stream_profile(ob2_imu_config_t imu_config_handle, const ob2_accel_stream_profile_t *stream_profile, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(imu_config_handle, "imu_config_handle")->accel_profile = *check_handle(stream_profile, "stream_profile");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_imu_config_enable_accel_stream(ob2_imu_config_t imu_config_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(imu_config_handle, "imu_config_handle")->accel = true;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_imu_config_disable_accel_stream(ob2_imu_config_t imu_config_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(imu_config_handle, "imu_config_handle")->accel = false;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_imu_config_set_gyro_stream_profile(ob2_imu_config_t imu_config_handle, const ob2_gyro_stream_profile_t *stream_profile, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(imu_config_handle, "imu_config_handle")->gyro_profile = *check_handle(stream_profile, "stream_profile");
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_imu_config_enable_gyro_stream(ob2_imu_config_t imu_config_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(imu_config_handle, "imu_config_handle")->gyro = true;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_imu_config_disable_gyro_stream(ob2_imu_config_t imu_config_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(imu_config_handle, "imu_config_handle")->gyro = false;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_device_start_imu(ob2_device_t device_handle, const ob2_imu_config_t imu_config_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    start_imu(device_handle, imu_config_handle, nullptr, nullptr);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_device_start_imu_with_callback(ob2_device_t device_handle, const ob2_imu_config_t imu_config_handle, ob2_imu_sample_cb_t cb, void *user_data,
+                                        ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    start_imu(device_handle, imu_config_handle, check_handle(cb, "cb"), user_data);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_device_update_imu_config(ob2_device_t device_handle, const ob2_imu_config_t imu_config_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    if (!device_handle->imu_running) {
+        throw logic_error("IMU is not started");
+    }
+    OB2ImuConfigImpl config = imu_config_handle != OB2_DEFAULT_IMU_CONFIG ? *imu_config_handle : OB2ImuConfigImpl();
+    stop_imu_thread(device_handle);
+    start_imu_thread(device_handle, config);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_device_stop_imu(ob2_device_t device_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    stop_imu(check_handle(device_handle, "device_handle"));
+    OB2SIM_CATCH(status, )
+}
+
+ob2_imu_sample_t ob2_device_get_imu_sample(ob2_device_t device_handle, int32_t timeout_msec, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(device_handle, "device_handle");
+    std::unique_lock<std::mutex> lock(device_handle->mutex);
+    auto ready = [device_handle] { return !device_handle->imu_samples.empty() || !device_handle->imu_running; };
+    if (timeout_msec == OB2_WAIT_INFINITE) {
+        device_handle->ready.wait(lock, ready);
+    }
+    else if (!device_handle->ready.wait_for(lock, std::chrono::milliseconds(std::max(0, timeout_msec)), ready)) {
+        throw std::runtime_error("Timeout waiting for IMU sample");
+    }
+    if (device_handle->imu_samples.empty()) {
+        throw std::runtime_error("IMU is not started");
+    }
+    ob2_imu_sample_t sample = device_handle->imu_samples.front();
+    device_handle->imu_samples.pop_front();
+    return sample;
+    OB2SIM_CATCH(status, nullptr)
+}
+
+void ob2_imu_sample_reference(ob2_imu_sample_t imu_sample_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    ++check_handle(imu_sample_handle, "imu_sample_handle")->refs;
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_imu_sample_release(ob2_imu_sample_t imu_sample_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    if (--check_handle(imu_sample_handle, "imu_sample_handle")->refs == 0) {
+        delete imu_sample_handle;
+    }
+    OB2SIM_CATCH(status, )
+}
+
+uint32_t ob2_imu_sample_get_accel_sample_count(ob2_imu_sample_t imu_sample_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return (uint32_t)check_handle(imu_sample_handle, "imu_sample_handle")->accel.size();
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_accel_sample_t ob2_imu_sample_get_accel_sample(ob2_imu_sample_t imu_sample_handle, uint32_t index, ob2_status_t *status) {
+    ob2_accel_sample_t sample = {0, 0, 0, 0, 0};
+    OB2SIM_TRY(status)
+    check_handle(imu_sample_handle, "imu_sample_handle");
+    if (index >= imu_sample_handle->accel.size()) {
+        throw logic_error("Accel sample index " + std::to_string(index) + " out of range");
+    }
+    return imu_sample_handle->accel[index];
+    OB2SIM_CATCH(status, sample)
+}
+
+uint32_t ob2_imu_sample_get_gyro_sample_count(ob2_imu_sample_t imu_sample_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    return (uint32_t)check_handle(imu_sample_handle, "imu_sample_handle")->gyro.size();
+    OB2SIM_CATCH(status, 0)
+}
+
+ob2_gyro_sample_t ob2_imu_sample_get_gyro_sample(ob2_imu_sample_t imu_sample_handle, uint32_t index, ob2_status_t *status) {
+    ob2_gyro_sample_t sample = {0, 0, 0, 0, 0};
+    OB2SIM_TRY(status)
+    check_handle(imu_sample_handle, "imu_sample_handle");
+    if (index >= imu_sample_handle->gyro.size()) {
+        throw logic_error("Gyro sample index " + std::to_string(index) + " out of range");
+    }
+    return imu_sample_handle->gyro[index];
+    OB2SIM_CATCH(status, sample)
+}
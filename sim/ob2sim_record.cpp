@@ -0,0 +1,377 @@
+#include "ob2sim.hpp"
+
+#include <cstdlib>
+
+// 录制文件格式：8 字节的 "OB2SIMR1"，之后是一串记录，每条为 uint32 类型、uint32 长度和内容，按本机字节序写入。
+// capture 记录开头是写入时的 steady_usec()，回放时按写入的时间间隔输出，与 SDK 的约定一致
+namespace ob2sim {
+
+static const char record_magic[8] = {'O', 'B', '2', 'S', 'I', 'M', 'R', '1'};
+
+enum record_kind : uint32_t {
+    record_device_info = 1,
+    record_calibration = 2,
+    record_capture = 3,
+    record_imu_sample = 4,
+};
+
+// capture 记录中每张图像的头，字段按大小排列，没有填充
+struct image_header {
+    uint64_t device_timestamp_usec;
+    uint64_t system_timestamp_usec;
+    uint32_t camera, format, width, height, stride, size, bits;
+    float value_scale;
+};
+
+}  // namespace ob2sim
+
+using namespace ob2sim;
+
+struct OB2RecordImpl {
+    std::mutex mutex;  // 各数据流的回调可能在不同线程中写入
+    std::FILE *fp = nullptr;
+
+    void write(uint32_t kind, const std::vector<uint8_t> &payload) {
+        const uint32_t head[2] = {kind, (uint32_t)payload.size()};
+        std::lock_guard<std::mutex> lock(mutex);
+        if (std::fwrite(head, sizeof(head), 1, fp) != 1 || (!payload.empty() && std::fwrite(payload.data(), payload.size(), 1, fp) != 1)) {
+            throw std::runtime_error("Fail to write recording");
+        }
+    }
+};
+
+struct OB2PlaybackImpl {
+    std::FILE *fp = nullptr;
+    long data_offset = sizeof(record_magic);
+    bool has_device_info = false, has_calibration = false;
+    ob2_device_info_t device_info;
+    ob2_cameras_calibration_t calibration;
+    bool realtime = true;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable stopped;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> generation{0};  // 每次启动加一，在回调中停止后又重新启动时旧线程据此退出
+    std::mutex thread_mutex;           // 保护 thread 和 retired
+    std::vector<std::thread> retired;  // 在自己的回调中停止的回放线程，关闭时等待其结束
+};
+
+template <typename T> static void append(std::vector<uint8_t> &out, const T &value) {
+    const uint8_t *p = (const uint8_t *)&value;
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template <typename T> static T take(const std::vector<uint8_t> &in, size_t &pos) {
+    if (pos + sizeof(T) > in.size()) {
+        throw std::runtime_error("Truncated record in recording");
+    }
+    T value;
+    std::memcpy(&value, in.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+// 读取下一条记录，文件结束时返回 false
+static bool read_record(std::FILE *fp, uint32_t &kind, std::vector<uint8_t> &payload) {
+    uint32_t head[2];
+    if (std::fread(head, sizeof(head), 1, fp) != 1) {
+        return false;
+    }
+    kind = head[0];
+    payload.resize(head[1]);
+    if (!payload.empty() && std::fread(payload.data(), payload.size(), 1, fp) != 1) {
+        throw std::runtime_error("Truncated record in recording");
+    }
+    return true;
+}
+
+ob2_record_t ob2_record_create(const char *file_path, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::unique_ptr<OB2RecordImpl> rec(new OB2RecordImpl());
+    rec->fp = std::fopen(check_handle(file_path, "file_path"), "wb");
+    if (rec->fp == nullptr) {
+        throw std::runtime_error(std::string("Fail to create ") + file_path);
+    }
+    if (std::fwrite(record_magic, sizeof(record_magic), 1, rec->fp) != 1) {
+        std::fclose(rec->fp);
+        throw std::runtime_error(std::string("Fail to write ") + file_path);
+    }
+    return rec.release();
+    OB2SIM_CATCH(status, nullptr)
+}
+
+// 写入是同步的，没有内部缓存，冲洗只需把 stdio 的缓冲写入文件
+void ob2_record_flush(ob2_record_t recording_handle, int32_t, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::lock_guard<std::mutex> lock(check_handle(recording_handle, "recording_handle")->mutex);
+    if (std::fflush(recording_handle->fp) != 0) {
+        throw std::runtime_error("Fail to flush recording");
+    }
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_record_close(ob2_record_t recording_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::unique_ptr<OB2RecordImpl> rec(check_handle(recording_handle, "recording_handle"));
+    if (std::fclose(rec->fp) != 0) {
+        throw std::runtime_error("Fail to close recording");
+    }
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_record_write_device_info(ob2_record_t recording_handle, const ob2_device_info_t *device_info, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::vector<uint8_t> payload;
+    append(payload, *check_handle(device_info, "device_info"));
+    check_handle(recording_handle, "recording_handle")->write(record_device_info, payload);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_record_write_cameras_calibration(ob2_record_t recording_handle, const ob2_cameras_calibration_t *calibration, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::vector<uint8_t> payload;
+    append(payload, *check_handle(calibration, "calibration"));
+    check_handle(recording_handle, "recording_handle")->write(record_calibration, payload);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_record_write_capture(ob2_record_t recording_handle, const ob2_capture_t capture_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(recording_handle, "recording_handle");
+    check_handle(capture_handle, "capture_handle");
+    std::vector<uint8_t> payload;
+    append(payload, steady_usec());
+    uint32_t count = 0;
+    for (ob2_image_t im : capture_handle->images) {
+        count += im != nullptr;
+    }
+    append(payload, count);
+    for (ob2_image_t im : capture_handle->images) {
+        if (im == nullptr) {
+            continue;
+        }
+        image_header h = {im->device_timestamp_usec, im->system_timestamp_usec, (uint32_t)im->camera, (uint32_t)im->format, im->width, im->height,
+                          im->stride, im->size, im->bits, im->value_scale};
+        append(payload, h);
+        payload.insert(payload.end(), im->buffer, im->buffer + im->size);
+    }
+    recording_handle->write(record_capture, payload);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_record_write_imu_sample(ob2_record_t recording_handle, const ob2_imu_sample_t imu_sample_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(recording_handle, "recording_handle");
+    check_handle(imu_sample_handle, "imu_sample_handle");
+    std::vector<uint8_t> payload;
+    append(payload, steady_usec());
+    append(payload, (uint32_t)imu_sample_handle->accel.size());
+    append(payload, (uint32_t)imu_sample_handle->gyro.size());
+    for (auto &s : imu_sample_handle->accel) {
+        append(payload, s);
+    }
+    for (auto &s : imu_sample_handle->gyro) {
+        append(payload, s);
+    }
+    recording_handle->write(record_imu_sample, payload);
+    OB2SIM_CATCH(status, )
+}
+
+static ob2_capture_t parse_capture(const std::vector<uint8_t> &payload, size_t pos) {
+    std::unique_ptr<OB2CaptureImpl> capture(new OB2CaptureImpl());
+    const uint32_t count = take<uint32_t>(payload, pos);
+    for (uint32_t i = 0; i < count; ++i) {
+        const image_header h = take<image_header>(payload, pos);
+        if (h.camera >= (uint32_t)camera_slots || pos + h.size > payload.size()) {
+            throw std::runtime_error("Invalid image in recording");
+        }
+        OB2ImageImpl *im = new OB2ImageImpl();
+        im->camera = (ob2_camera_type_t)h.camera;
+        im->format = (ob2_image_format_t)h.format;
+        im->width = h.width;
+        im->height = h.height;
+        im->stride = h.stride;
+        im->storage.assign(payload.begin() + pos, payload.begin() + pos + h.size);
+        im->buffer = im->storage.data();
+        im->size = h.size;
+        im->device_timestamp_usec = h.device_timestamp_usec;
+        im->system_timestamp_usec = h.system_timestamp_usec;
+        im->bits = (uint8_t)h.bits;
+        im->value_scale = h.value_scale;
+        pos += h.size;
+        if (capture->images[h.camera] != nullptr) {
+            ob2_image_release(capture->images[h.camera], nullptr);
+        }
+        capture->images[h.camera] = im;
+    }
+    return capture.release();
+}
+
+static ob2_imu_sample_t parse_imu_sample(const std::vector<uint8_t> &payload, size_t pos) {
+    std::unique_ptr<OB2ImuSampleImpl> sample(new OB2ImuSampleImpl());
+    const uint32_t n_accel = take<uint32_t>(payload, pos), n_gyro = take<uint32_t>(payload, pos);
+    for (uint32_t i = 0; i < n_accel; ++i) {
+        sample->accel.push_back(take<ob2_accel_sample_t>(payload, pos));
+    }
+    for (uint32_t i = 0; i < n_gyro; ++i) {
+        sample->gyro.push_back(take<ob2_gyro_sample_t>(payload, pos));
+    }
+    return sample.release();
+}
+
+// 从头到尾读一遍文件，按写入的时间间隔输出 capture 和 imu_sample，结束或停止后报告 OB2_PLAYBACK_END
+static void playback_loop(ob2_playback_t pb, uint64_t generation, ob2_capture_cb_t capture_cb, ob2_imu_sample_cb_t imu_cb, ob2_playback_state_cb_t state_cb,
+                          void *user_data) {
+    auto active = [pb, generation] { return pb->running && pb->generation == generation; };
+    if (state_cb != nullptr) {
+        state_cb(OB2_PLAYBACK_BEGIN, user_data);
+    }
+    try {
+        std::fseek(pb->fp, pb->data_offset, SEEK_SET);
+        uint64_t first_write = 0, start = steady_usec();
+        bool first = true;
+        uint32_t kind;
+        std::vector<uint8_t> payload;
+        while (active() && read_record(pb->fp, kind, payload)) {
+            if ((kind != record_capture || capture_cb == nullptr) && (kind != record_imu_sample || imu_cb == nullptr)) {
+                continue;
+            }
+            size_t pos = 0;
+            const uint64_t write_usec = take<uint64_t>(payload, pos);
+            if (first) {
+                first_write = write_usec;
+                first = false;
+            }
+            if (pb->realtime && write_usec > first_write) {
+                std::unique_lock<std::mutex> lock(pb->mutex);
+                auto due = std::chrono::steady_clock::time_point(std::chrono::microseconds(start + (write_usec - first_write)));
+                if (pb->stopped.wait_until(lock, due, [&active] { return !active(); })) {
+                    break;
+                }
+            }
+            // 回调取得所有权
+            if (kind == record_capture) {
+                capture_cb(parse_capture(payload, pos), user_data);
+            }
+            else {
+                imu_cb(parse_imu_sample(payload, pos), user_data);
+            }
+        }
+    }
+    catch (const std::exception &e) {
+        std::fprintf(stderr, "ob2sim: playback stopped: %s\n", e.what());
+    }
+    {
+        // 已在回调中重新启动时不影响新的回放
+        std::lock_guard<std::mutex> lock(pb->mutex);
+        if (pb->generation == generation) {
+            pb->running = false;
+        }
+    }
+    if (state_cb != nullptr) {
+        state_cb(OB2_PLAYBACK_END, user_data);
+    }
+}
+
+// 在回调中停止时不能等待自己，回调返回后线程自行退出，由之后的 stop、start 或关闭等待
+static void stop_playback(ob2_playback_t pb) {
+    {
+        std::lock_guard<std::mutex> lock(pb->mutex);
+        pb->running = false;
+    }
+    pb->stopped.notify_all();
+    retire_or_join(pb->thread, pb->thread_mutex, pb->retired);
+    join_retired(pb->thread_mutex, pb->retired);
+}
+
+ob2_playback_t ob2_playback_create(const char *file_path, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::unique_ptr<OB2PlaybackImpl> pb(new OB2PlaybackImpl());
+    pb->fp = std::fopen(check_handle(file_path, "file_path"), "rb");
+    if (pb->fp == nullptr) {
+        throw std::runtime_error(std::string("Fail to open ") + file_path);
+    }
+    try {
+        char magic[sizeof(record_magic)];
+        if (std::fread(magic, sizeof(magic), 1, pb->fp) != 1 || std::memcmp(magic, record_magic, sizeof(magic)) != 0) {
+            throw std::runtime_error(std::string(file_path) + " is not a simulator recording");
+        }
+        // 设备信息和标定参数可能写在任意位置，创建时先找出来
+        uint32_t kind;
+        std::vector<uint8_t> payload;
+        while (read_record(pb->fp, kind, payload)) {
+            size_t pos = 0;
+            if (kind == record_device_info) {
+                pb->device_info = take<ob2_device_info_t>(payload, pos);
+                pb->has_device_info = true;
+            }
+            else if (kind == record_calibration) {
+                pb->calibration = take<ob2_cameras_calibration_t>(payload, pos);
+                pb->has_calibration = true;
+            }
+        }
+    }
+    catch (...) {
+        std::fclose(pb->fp);
+        throw;
+    }
+    // 回放器不属于任何上下文，只从环境变量读取是否按时间间隔输出
+    const char *realtime = std::getenv("OB2SIM_REALTIME");
+    pb->realtime = realtime == nullptr || std::strcmp(realtime, "0") != 0;
+    return pb.release();
+    OB2SIM_CATCH(status, nullptr)
+}
+
+void ob2_playback_close(ob2_playback_t playback_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    std::unique_ptr<OB2PlaybackImpl> pb(check_handle(playback_handle, "playback_handle"));
+    stop_playback(pb.get());
+    abandon_retired(pb->thread_mutex, pb->retired, "playback");
+    std::fclose(pb->fp);
+    OB2SIM_CATCH(status, )
+}
+
+ob2_device_info_t ob2_playback_get_device_info(ob2_playback_t playback_handle, ob2_status_t *status) {
+    ob2_device_info_t info;
+    std::memset(&info, 0, sizeof(info));
+    OB2SIM_TRY(status)
+    if (!check_handle(playback_handle, "playback_handle")->has_device_info) {
+        throw std::runtime_error("No device info in recording");
+    }
+    return playback_handle->device_info;
+    OB2SIM_CATCH(status, info)
+}
+
+ob2_cameras_calibration_t ob2_playback_get_cameras_calibration(ob2_playback_t playback_handle, ob2_status_t *status) {
+    ob2_cameras_calibration_t cal;
+    std::memset(&cal, 0, sizeof(cal));
+    OB2SIM_TRY(status)
+    if (!check_handle(playback_handle, "playback_handle")->has_calibration) {
+        throw std::runtime_error("No cameras calibration in recording");
+    }
+    return playback_handle->calibration;
+    OB2SIM_CATCH(status, cal)
+}
+
+void ob2_playback_start(ob2_playback_t playback_handle, ob2_capture_cb_t capture_callback, ob2_imu_sample_cb_t imu_sample_callback,
+                        ob2_playback_state_cb_t state_callback, void *user_data, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    check_handle(playback_handle, "playback_handle");
+    if (playback_handle->running) {
+        throw logic_error("Playback is already started");
+    }
+    stop_playback(playback_handle);
+    const uint64_t generation = ++playback_handle->generation;
+    playback_handle->running = true;
+    std::lock_guard<std::mutex> lock(playback_handle->thread_mutex);
+    playback_handle->thread =
+        std::thread(playback_loop, playback_handle, generation, capture_callback, imu_sample_callback, state_callback, user_data);
+    OB2SIM_CATCH(status, )
+}
+
+void ob2_playback_stop(ob2_playback_t playback_handle, ob2_status_t *status) {
+    OB2SIM_TRY(status)
+    stop_playback(check_handle(playback_handle, "playback_handle"));
+    OB2SIM_CATCH(status, )
+}